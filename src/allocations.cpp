@@ -0,0 +1,64 @@
+#include "allocations.hpp"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#ifdef TRACK_ALLOCATIONS
+
+// plain counters, so they need no constructor and are safe to touch from the first allocation a thread makes.
+static thread_local Allocations::Count counted = { 0, 0 };
+
+static inline void count(size_t bytes) {
+  counted.allocations++;
+  counted.bytes += bytes;
+}
+
+void* operator new(size_t size) {
+  count(size);
+  if (void* memory = malloc(size ? size : 1)) return memory;
+  throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+  count(size);
+  size_t align = static_cast<size_t>(alignment);
+  // aligned_alloc wants the size to be a multiple of the alignment.
+  if (void* memory = aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) / align * align)) return memory;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { free(memory); }
+
+// SDL's defaults are the C library's, so memory allocated before the hook went in can still be freed through it.
+static void* countedMalloc(size_t size) {
+  count(size);
+  return malloc(size);
+}
+
+static void* countedCalloc(size_t items, size_t size) {
+  count(items * size);
+  return calloc(items, size);
+}
+
+// a realloc can move the block, so every one counts.
+static void* countedRealloc(void* memory, size_t size) {
+  count(size);
+  return realloc(memory, size);
+}
+
+bool Allocations::hookSdl() {
+  return SDL_SetMemoryFunctions(countedMalloc, countedCalloc, countedRealloc, free) == 0;
+}
+
+Allocations::Count Allocations::thisThread() {
+  return counted;
+}
+
+#else
+
+bool Allocations::hookSdl() { return true; }
+Allocations::Count Allocations::thisThread() { return { 0, 0 }; }
+
+#endif
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+// heap allocations counted per thread, to catch the frame loop allocating. only builds made with
+// TRACK_ALLOCATIONS=1 count anything: they replace the global operator new and delete, and have SDL allocate through
+// counted functions too. in other builds every count stays 0 and nothing is hooked.
+namespace Allocations {
+  struct Count {
+    uint64_t allocations;
+    uint64_t bytes;
+
+    inline Count operator-(const Count& other) const {
+      return { allocations - other.allocations, bytes - other.bytes };
+    }
+  };
+
+#ifdef TRACK_ALLOCATIONS
+  constexpr bool TRACKED = true;
+#else
+  constexpr bool TRACKED = false;
+#endif
+
+  // frames after startup, a resize or switching the bot or hint on, before the loop counts as steady.
+  // buffers that grow to fit the game are still growing until then.
+  constexpr int WARMUP_FRAMES = 300;
+
+  // routes SDL's allocations through the counted functions. call before SDL_Init. returns false if SDL refused.
+  bool hookSdl();
+  // allocations made by the calling thread so far, whether through new or SDL.
+  Count thisThread();
+}
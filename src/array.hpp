@@ -1,5 +1,6 @@
 #pragma once
 #include <array>
+#include <cstddef>
 
 template <typename T, size_t width, size_t height>
 class array2d : public std::array<T, width * height> {
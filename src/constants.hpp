@@ -1,9 +1,12 @@
 #pragma once
 #include <tuple>
 
+// pixel size of a tile in a window of the default size. only the front-end deals in pixels.
 constexpr int TILE_SIZE = 40;
 constexpr int COLUMNS = 10;
 constexpr int ROWS = 20;
+// rows above the visible field that blocks spawn into and may lock in, as in the guideline's 10x40 layout.
+constexpr int HIDDEN_ROWS = 20;
 constexpr int TOTAL_TILE_COUNT = COLUMNS * ROWS;
 
 class Color {
@@ -28,23 +31,63 @@ namespace Colors {
   constexpr Color darkBlue = { 0, 97, 171 };
   constexpr Color violet = { 127, 0, 255 };
   constexpr Color shadow = { 50, 50, 50 };
+  // tiles of a perfect clear found for the player, under the ghost.
+  constexpr Color hint = { 30, 70, 60 };
+  constexpr Color garbage = { 110, 110, 110 };
   constexpr Color empty = { 30, 30, 30 };
   constexpr Color dead = { 50, 30, 30 };
 }
 
+// the size the window opens at. it can be resized, and the board is scaled to fit.
 namespace Window {
   constexpr int HEIGHT = ROWS * TILE_SIZE;
   constexpr int WIDTH = COLUMNS * TILE_SIZE;
 }
 
 namespace FPS {
-  constexpr int FPS = 30;
+  // frame rate cap for renderers that can't wait for the display's vertical sync.
+  constexpr int FPS = 144;
   constexpr int FRAME_DELAY = 1000 / FPS;
 }
 
+// gameplay timings are in milliseconds and converted with whatever tick rate the engine runs at.
+namespace Rules {
+  // simulation steps per second, unless the engine is told otherwise.
+  constexpr int TICK_RATE = 240;
+  // the level curve is counted in 30ths of a second: a row per 30 of them at level 1, 10% fewer (rounded down) each level.
+  constexpr int GRAVITY_RATE = 30;
+  // how long a block may rest on the stack before it locks, and how often moving it can restart that wait.
+  constexpr int LOCK_DELAY = 500;
+  constexpr int LOCK_RESETS = 4;
+  // upcoming blocks shown ahead of time.
+  constexpr int PREVIEW = 5;
+  // seconds of play that holding R can take back.
+  constexpr int REWIND_SECONDS = 10;
+}
+
+namespace Controls {
+  // sideways keys start repeating once held for DAS ms, then move every ARR ms.
+  constexpr int DAS = 100;
+  constexpr int ARR = 1000 / 15;
+  // a held soft drop falls this many times faster than gravity (and at least every ARR).
+  constexpr int SOFT_DROP_FACTOR = 20;
+  // the bot places at most one block per this many ms, so it can be watched.
+  constexpr int BOT_INTERVAL = 1000 / 30;
+}
+
+namespace Versus {
+  // garbage lines sent for clearing 0 to 4 lines at once.
+  constexpr int ATTACK[5] = { 0, 0, 1, 2, 4 };
+  // one-way delay of the simulated link in ms, how much later than that a datagram may turn up, and the percentage lost.
+  constexpr int LATENCY = 40;
+  constexpr int JITTER = 10;
+  constexpr int LOSS = 0;
+}
+
 namespace Assets {
   namespace Fonts {
     constexpr char const *FONT = "./assets/fonts/font.ttf";
-    constexpr int SIZE = 200;
+    // point size as a fraction of the tile size. text is rasterised again whenever the tiles change size, and drawn 1:1.
+    constexpr float SIZE = 0.4f;
   }
 }
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "controller.hpp"
+#include <algorithm>
+
+Controller::Controller():
+  frequency(1000),
+  epoch(0),
+  epochTicks(0),
+  processed(0),
+  head(0),
+  count(0),
+  pending(0),
+  latencies{},
+  sampleCount(0)
+{
+  reset();
+}
+
+void Controller::init() {
+  frequency = SDL_GetPerformanceFrequency();
+  epochTicks = SDL_GetTicks64();
+  epoch = SDL_GetPerformanceCounter();
+  processed = epoch;
+}
+
+void Controller::reset() {
+  head = 0;
+  count = 0;
+  held.fill(false);
+  direction = 0;
+  repeatAt = ~0ull;
+  dropAt = ~0ull;
+  pending = 0;
+}
+
+bool Controller::handle(const SDL_KeyboardEvent& event) {
+  Action action;
+
+  switch (event.keysym.scancode) {
+    case SDL_SCANCODE_LEFT: action = Action::Left; break;
+    case SDL_SCANCODE_RIGHT: action = Action::Right; break;
+    case SDL_SCANCODE_DOWN: action = Action::Down; break;
+    case SDL_SCANCODE_SPACE: action = Action::Drop; break;
+    case SDL_SCANCODE_UP: action = Action::Clockwise; break;
+    case SDL_SCANCODE_Z: action = Action::Counterclockwise; break;
+    case SDL_SCANCODE_C: action = Action::Swap; break;
+    case SDL_SCANCODE_R: action = Action::Rewind; break;
+    default: return false;
+  }
+
+  // the system's own key repeat is ignored; holding keys is timed here.
+  if (event.repeat) return true;
+  if (count == QUEUE_SIZE) return true;
+
+  queue[(head + count) % QUEUE_SIZE] = { toCounter(event.timestamp), action, event.state == SDL_PRESSED };
+  count++;
+  return true;
+}
+
+uint64_t Controller::toCounter(uint32_t milliseconds) const {
+  int64_t since = int64_t(milliseconds) - int64_t(epochTicks);
+  return epoch + since * int64_t(frequency) / 1000;
+}
+
+uint64_t Controller::fromMilliseconds(double milliseconds) const {
+  return uint64_t(milliseconds * frequency / 1000);
+}
+
+uint64_t Controller::nextRepeat() const {
+  return direction != 0 ? repeatAt : ~0ull;
+}
+
+void Controller::update(const Engine& engine, uint64_t until, std::vector<Input>& inputs) {
+  uint64_t das = fromMilliseconds(Controls::DAS);
+  uint64_t arr = std::max<uint64_t>(fromMilliseconds(Controls::ARR), 1);
+  // never slower than one row per ARR, however slow gravity is.
+  uint64_t softDrop = std::min(arr, fromMilliseconds(1000 / (engine.getFallSpeed() * Controls::SOFT_DROP_FACTOR)));
+  softDrop = std::max<uint64_t>(softDrop, 1);
+
+  auto act = [&](Input input, uint64_t time) {
+    if (!pending) pending = time;
+    inputs.push_back(input);
+  };
+
+  while (true) {
+    // events stamped before the last tick ran (they were read late) act on this one.
+    uint64_t eventAt = count > 0 ? std::max(queue[head].time, processed) : ~0ull;
+    uint64_t moveAt = nextRepeat();
+    uint64_t dropDue = held[Action::Down] ? dropAt : ~0ull;
+
+    uint64_t at = std::min({ eventAt, moveAt, dropDue });
+    if (at > until) break;
+    processed = at;
+
+    if (at == moveAt) {
+      act(direction < 0 ? Input::MoveLeft : Input::MoveRight, at);
+      repeatAt = at + arr;
+      continue;
+    }
+
+    if (at == dropDue) {
+      act(Input::SoftDrop, at);
+      dropAt = at + softDrop;
+      continue;
+    }
+
+    Event event = queue[head];
+    head = (head + 1) % QUEUE_SIZE;
+    count--;
+
+    if (event.down == held[event.action]) continue;
+    held[event.action] = event.down;
+
+    // only presses act; a release just stops whatever the key was repeating.
+    switch (event.action) {
+      case Action::Left:
+      case Action::Right: {
+        int side = event.action == Action::Left ? -1 : 1;
+
+        if (event.down) {
+          direction = side;
+          repeatAt = at + das;
+          act(side < 0 ? Input::MoveLeft : Input::MoveRight, event.time);
+        } else if (direction == side) {
+          // the other key takes over if it's still down, carrying on at the repeat rate.
+          direction = held[side < 0 ? Action::Right : Action::Left] ? -side : 0;
+          repeatAt = at + arr;
+        }
+
+        break;
+      }
+      case Action::Down:
+        if (event.down) {
+          act(Input::SoftDrop, event.time);
+          dropAt = at + softDrop;
+        }
+        break;
+      case Action::Drop:
+        if (event.down) act(Input::HardDrop, event.time);
+        break;
+      case Action::Clockwise:
+        if (event.down) act(Input::RotateClockwise, event.time);
+        break;
+      case Action::Counterclockwise:
+        if (event.down) act(Input::RotateCounterclockwise, event.time);
+        break;
+      case Action::Swap:
+        if (event.down) act(Input::Hold, event.time);
+        break;
+      default:
+        break;
+    }
+  }
+
+  processed = std::max(processed, until);
+}
+
+void Controller::presented(uint64_t time) {
+  if (!pending) return;
+
+  latencies[sampleCount % SAMPLES] = float(double(time - std::min(time, pending)) * 1000 / frequency);
+  sampleCount++;
+  pending = 0;
+}
+
+float Controller::averageLatency() const {
+  int samples = std::min(sampleCount, SAMPLES);
+  if (samples == 0) return 0;
+
+  float total = 0;
+  for (int i = 0; i < samples; i++) total += latencies[i];
+  return total / samples;
+}
+
+float Controller::worstLatency() const {
+  int samples = std::min(sampleCount, SAMPLES);
+  return samples == 0 ? 0 : *std::max_element(latencies.begin(), latencies.begin() + samples);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include "constants.hpp"
+#include "engine/engine.hpp"
+#include <array>
+#include <vector>
+
+// turns key events into engine inputs at the time they happened rather than the frame they were read in.
+// times are SDL_GetPerformanceCounter values. events keep their SDL timestamps, and auto-repeat (DAS, then ARR)
+// is scheduled to the exact time it is due, so the tick that covers that time is the one that acts on it.
+class Controller {
+public:
+  Controller();
+
+  // call once SDL is up. ties SDL event timestamps to the performance counter.
+  void init();
+  // forgets held keys and queued events, e.g. when a game ends.
+  void reset();
+
+  // queues a key press or release. returns false for keys that aren't bound.
+  bool handle(const SDL_KeyboardEvent& event);
+
+  // appends every input due up to the end of the tick at time until, in the order they were due.
+  void update(const Engine& engine, uint64_t until, std::vector<Input>& inputs);
+  // whether the rewind key was down as of the last update. play runs backwards while it is.
+  inline bool rewinding() const { return held[Action::Rewind]; }
+
+  // the time a frame showing everything sent so far reached the screen. feeds the latency figures.
+  void presented(uint64_t time);
+  // input-to-present latency over the last few inputs, in milliseconds.
+  float averageLatency() const;
+  float worstLatency() const;
+private:
+  enum Action {
+    Left, Right, Down, Drop, Clockwise, Counterclockwise, Swap, Rewind, ACTIONS
+  };
+
+  struct Event {
+    uint64_t time;
+    Action action;
+    bool down;
+  };
+
+  static constexpr int QUEUE_SIZE = 64;
+  static constexpr int SAMPLES = 64;
+
+  uint64_t toCounter(uint32_t milliseconds) const;
+  uint64_t fromMilliseconds(double milliseconds) const;
+  // the held direction's next repeat, or ~0 if nothing is repeating.
+  uint64_t nextRepeat() const;
+
+  uint64_t frequency;
+  // a counter value and the SDL_GetTicks value taken together.
+  uint64_t epoch;
+  uint64_t epochTicks;
+  // everything before this has been handed to the engine.
+  uint64_t processed;
+
+  std::array<Event, QUEUE_SIZE> queue;
+  int head;
+  int count;
+
+  std::array<bool, ACTIONS> held;
+  // the sideways key pressed last wins while both are down. 0 while neither is.
+  int direction;
+  uint64_t repeatAt;
+  uint64_t dropAt;
+
+  // the oldest input that has acted but not been shown yet, or 0.
+  uint64_t pending;
+  std::array<float, SAMPLES> latencies;
+  int sampleCount;
+};
@@ -0,0 +1,25 @@
+#pragma once
+#include "../constants.hpp"
+#include <array>
+#include <cstdint>
+
+enum BlockType : uint8_t {
+  None, I, O, T, L, J, S, Z
+};
+
+// a tile on the board, with row 0 at the bottom.
+struct Coords {
+  int x, y;
+};
+
+// the falling block. its tiles come from Pieces::SHAPES, so this is all there is to it.
+struct Block {
+  BlockType type = BlockType::None;
+
+  // amount of times rotated clockwise
+  int8_t rotation = 0;
+
+  // tile the block rotates around. the shape tables are relative to it.
+  int8_t x = 0;
+  int8_t y = 0;
+};
@@ -0,0 +1,126 @@
+#include "board.hpp"
+#include <bit>
+
+template <int Columns, int Rows>
+void BasicBoard<Columns, Rows>::clear() {
+  std::fill(rows.begin(), rows.begin() + FLOOR, FULL_ROW);
+  std::fill(rows.begin() + FLOOR, rows.end(), EMPTY_ROW);
+
+  tiles.fill(EMPTY);
+
+  heights.fill(0);
+  top = 0;
+  key = 0;
+}
+
+template <int Columns, int Rows>
+int BasicBoard<Columns, Rows>::clearLines() {
+  int lowest = 0;
+  while (lowest < top && !rowFull(lowest)) lowest++;
+  if (lowest == top) return 0;
+
+  // everything from the lowest full row up moves, so its tiles are hashed out now and back in where they end up.
+  key ^= rowsKey(lowest, top);
+
+  int cleared = 0;
+  // nothing above the stack moves, so only the rows up to its top are shifted.
+  int height = top;
+
+  for (int row = height - 1; row >= lowest; row--) {
+    if (!rowFull(row)) continue;
+
+    std::copy(rows.begin() + FLOOR + row + 1, rows.begin() + FLOOR + height, rows.begin() + FLOOR + row);
+    rows[FLOOR + height - 1] = EMPTY_ROW;
+
+    std::copy(tiles[row + 1], tiles[height], tiles[row]);
+    std::fill(tiles[height - 1], tiles[height], EMPTY);
+
+    height--;
+    cleared++;
+  }
+
+  // columns only get shorter, so each walks down from where it was to its new top tile.
+  top = 0;
+  for (int x = 0; x < Columns; x++) {
+    int8_t height = heights[x];
+    while (height > 0 && !occupied(x, height - 1)) height--;
+
+    heights[x] = height;
+    top = std::max(top, height);
+  }
+
+  key ^= rowsKey(lowest, top);
+  return cleared;
+}
+
+template <int Columns, int Rows>
+bool BasicBoard<Columns, Rows>::rise(int lines, int hole) {
+  lines = std::min(lines, Rows);
+  bool fits = top + lines <= Rows;
+  // rows pushed past the top are lost.
+  int kept = std::min<int>(top, Rows - lines);
+
+  std::copy_backward(rows.begin() + FLOOR, rows.begin() + FLOOR + kept, rows.begin() + FLOOR + kept + lines);
+  std::copy_backward(tiles[0], tiles[kept], tiles[kept + lines]);
+
+  for (int y = 0; y < lines; y++) {
+    rows[FLOOR + y] = FULL_ROW & ~bit(hole);
+    std::fill(tiles[y], tiles[y + 1], GARBAGE);
+    tiles[y][hole] = EMPTY;
+  }
+
+  top = 0;
+  for (int x = 0; x < Columns; x++) {
+    int8_t height = heights[x] > 0 ? std::min(heights[x] + lines, Rows) : (x == hole ? 0 : lines);
+    // a column that lost its top tiles walks down to whatever is left.
+    if (!fits) while (height > 0 && !occupied(x, height - 1)) height--;
+
+    heights[x] = height;
+    top = std::max(top, height);
+  }
+
+  // every row moved.
+  key = rowsKey(0, top);
+  return fits;
+}
+
+template <int Columns, int Rows>
+bool BasicBoard<Columns, Rows>::valid() const {
+  for (int y = 0; y < FLOOR; y++)
+    if (rows[y] != FULL_ROW) return false;
+
+  for (int y = Rows; y < Rows + SKY; y++)
+    if (bits(y) != EMPTY_ROW) return false;
+
+  for (int y = 0; y < Rows; y++) {
+    if ((bits(y) & EMPTY_ROW) != EMPTY_ROW) return false;
+
+    for (int x = 0; x < Columns; x++)
+      if (tiles[y][x] > GARBAGE || (tiles[y][x] != EMPTY) != occupied(x, y)) return false;
+  }
+
+  int tallest = 0;
+  for (int x = 0; x < Columns; x++) {
+    int height = Rows;
+    while (height > 0 && !occupied(x, height - 1)) height--;
+
+    if (heights[x] != height) return false;
+    tallest = std::max(tallest, height);
+  }
+
+  return top == tallest && key == rowsKey(0, Rows);
+}
+
+template <int Columns, int Rows>
+uint64_t BasicBoard<Columns, Rows>::rowsKey(int from, int to) const {
+  uint64_t out = 0;
+  for (int y = from; y < to; y++)
+    for (Row filled = bits(y) & FIELD; filled; filled &= filled - 1)
+      out ^= Zobrist::cell(std::countr_zero(filled) - WALL, y);
+
+  return out;
+}
+
+template class BasicBoard<COLUMNS, ROWS + HIDDEN_ROWS>;
+template class BasicBoard<COLUMNS * 2, ROWS + HIDDEN_ROWS>;
+template class BasicBoard<COLUMNS, ROWS * 2 + HIDDEN_ROWS>;
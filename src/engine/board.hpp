@@ -0,0 +1,115 @@
+#pragma once
+
+#include "../constants.hpp"
+#include "../array.hpp"
+#include "zobrist.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+// the settled tiles. what filled each one (see Cell) is kept for drawing, while collision only ever looks at the
+// occupancy words: one per row, bit (x + WALL) set when column x is filled.
+// the bits either side of the field are always set and solid rows sit below the floor,
+// so walls and floor collide like any other tile and need no bounds checks.
+// coordinates are in tiles, with row 0 at the bottom.
+// the size is a template parameter so every loop over rows and columns has constant bounds; the sizes in use are
+// instantiated in board.cpp. Rows counts every row a tile can settle in, hidden ones included.
+template <int Columns, int Rows>
+class BasicBoard {
+public:
+  static constexpr int WALL = 4;
+  // the narrowest word that holds a row and both walls.
+  using Row = std::conditional_t<Columns + 2 * WALL <= 32, uint32_t, uint64_t>;
+  // a byte per tile: 0 for empty, otherwise the BlockType that left it there, or GARBAGE.
+  // renderers look the color up in Pieces::COLORS.
+  using Cell = uint8_t;
+  using CellGrid = array2d<Cell, Columns, Rows>;
+
+  static constexpr Cell EMPTY = 0;
+  static constexpr Cell GARBAGE = 8;
+
+  static constexpr int FLOOR = 4;
+  // open rows above the field for blocks spawning or rotating out of the top.
+  static constexpr int SKY = 8;
+  static constexpr int HEIGHT = FLOOR + Rows + SKY;
+
+  static constexpr Row FULL_ROW = ~Row(0);
+  static constexpr Row EMPTY_ROW = ~(((Row(1) << Columns) - 1) << WALL);
+  static constexpr Row FIELD = ~EMPTY_ROW;
+
+  static inline constexpr Row bit(int x) { return Row(1) << (x + WALL); }
+
+  BasicBoard() { clear(); }
+
+  void clear();
+
+  // removes full rows, moving everything above them down. returns how many were removed.
+  int clearLines();
+  // pushes the stack up by lines rows of garbage, each full but for column hole.
+  // returns false if that pushed tiles off the top of the field, which tops the stack out.
+  bool rise(int lines, int hole);
+
+  inline bool occupied(int x, int y) const {
+    return row(y) & bit(x);
+  }
+
+  // cells further than WALL outside the side walls are not supported; rows past the sky clamp to it.
+  template <typename Cells>
+  inline bool fits(const Cells& cells) const {
+    Row hit = 0;
+    for (const auto& cell : cells)
+      hit |= row(cell.y) & bit(cell.x);
+
+    return hit == 0;
+  }
+
+  inline void set(int x, int y, Cell cell) {
+    if (!(rows[y + FLOOR] & bit(x))) key ^= Zobrist::cell(x, y);
+    rows[y + FLOOR] |= bit(x);
+    tiles[y][x] = cell;
+
+    heights[x] = std::max<int8_t>(heights[x], y + 1);
+    top = std::max(top, heights[x]);
+  }
+
+  // rows from the floor up to and including the highest filled tile in column x, 0 if the column is empty.
+  // kept up to date by set(), clearLines() and rise(), so landing spots can be found without walking down the rows.
+  inline int height(int x) const { return heights[x]; }
+  // the tallest column.
+  inline int stackHeight() const { return top; }
+
+  // Zobrist hash of which tiles are filled (not what filled them). kept up to date like the heights: a tile at a time
+  // by set(), and by clearLines() and rise() for the rows they move.
+  inline uint64_t hash() const { return key; }
+
+  // whether the walls, floor and sky are intact and the tiles, heights and key agree with the occupancy words.
+  // always true of a board changed only through the calls above; for checking one read back from a file.
+  bool valid() const;
+
+  // occupancy word of a row inside the field, walls included.
+  inline Row bits(int y) const { return rows[y + FLOOR]; }
+  // the same words from row 0 up, for code reading several rows at once. the FLOOR solid rows are just before it
+  // and SKY empty ones follow the field.
+  inline const Row* rowData() const { return rows.data() + FLOOR; }
+
+  inline bool rowEmpty(int y) const { return rows[y + FLOOR] == EMPTY_ROW; }
+  inline bool rowFull(int y) const { return rows[y + FLOOR] == FULL_ROW; }
+
+  inline const CellGrid& cells() const { return tiles; }
+private:
+  inline Row row(int y) const {
+    return rows[std::clamp(y + FLOOR, 0, HEIGHT - 1)];
+  }
+
+  // the keys of the filled tiles in rows [from, to).
+  uint64_t rowsKey(int from, int to) const;
+
+  std::array<Row, HEIGHT> rows;
+  CellGrid tiles;
+  std::array<int8_t, Columns> heights;
+  int8_t top;
+  uint64_t key;
+};
+
+// the standard field: COLUMNS x ROWS on screen with HIDDEN_ROWS above it for blocks to spawn and settle in.
+using Board = BasicBoard<COLUMNS, ROWS + HIDDEN_ROWS>;
@@ -0,0 +1,181 @@
+#include "bot.hpp"
+#include <algorithm>
+
+Bot::Bot(TaskPool& pool, BotSettings settings):
+  pool(pool),
+  settings(settings),
+  evaluator(settings.weights),
+  level(0),
+  table(TABLE_SIZE),
+  salt(0),
+  outOfTime(false)
+{
+  for (unsigned i = 0; i < pool.size(); i++)
+    scratch.push_back(std::make_unique<Scratch>());
+  children.resize(pool.size());
+}
+
+float Bot::evaluate(const Board& board) const {
+  return evaluator.evaluate(board);
+}
+
+void Bot::score(std::vector<Node>& nodes, size_t first, Scratch& scratch) const {
+  scratch.boards.clear();
+  for (size_t i = first; i < nodes.size(); i++) scratch.boards.push_back(&nodes[i].board);
+
+  scratch.scores.resize(scratch.boards.size());
+  evaluator.evaluate(scratch.boards.data(), scratch.scores.data(), int(scratch.boards.size()));
+
+  for (size_t i = first; i < nodes.size(); i++) nodes[i].value = nodes[i].reward + scratch.scores[i - first];
+}
+
+bool Bot::play(const Node& node, BlockType type, BlockType hold, int next, const Placement& placement, Node& child) const {
+  child.board = node.board;
+
+  for (const Coords& cell : Pieces::cells(Pieces::SHAPES[type][placement.rotation], placement.x, placement.y)) {
+    // locking out of sight is legal while some of the block still shows, but never worth following.
+    if (cell.y >= ROWS) return false;
+    child.board.set(cell.x, cell.y, type);
+  }
+
+  int lines = child.board.clearLines();
+
+  child.hold = hold;
+  child.next = next;
+  child.reward = node.reward + settings.weights.lines * lines;
+  child.root = node.root;
+  return true;
+}
+
+bool Bot::firstVisit(const Node& node, int depth) {
+  uint64_t key = node.board.hash() ^ Zobrist::HOLD[node.hold]
+    ^ Zobrist::mix(salt ^ (uint64_t(node.next) << 48 | uint64_t(depth) << 40));
+
+  return table.visit(key);
+}
+
+void Bot::expand(const Node& node, int depth, std::vector<Node>& out, Scratch& scratch) {
+  if (std::chrono::steady_clock::now() > deadline) {
+    outOfTime = true;
+    return;
+  }
+
+  if (node.next >= (int)sequence.size()) return;
+
+  BlockType current = sequence[node.next];
+  size_t first = out.size();
+
+  auto branch = [&](BlockType type, BlockType hold, int next) {
+    scratch.placements.generate(node.board, type);
+    Node child;
+
+    for (const Placement& placement : scratch.placements.all()) {
+      if (!play(node, type, hold, next, placement, child)) continue;
+      if (firstVisit(child, depth)) out.push_back(child);
+    }
+  };
+
+  branch(current, node.hold, node.next + 1);
+
+  if (node.hold != BlockType::None && node.hold != current)
+    branch(node.hold, current, node.next + 1);
+  else if (node.hold == BlockType::None && node.next + 1 < (int)sequence.size())
+    branch(sequence[node.next + 1], current, node.next + 2);
+
+  // only the children that were new get scored, all in one go.
+  score(out, first, scratch);
+}
+
+void Bot::decide(const Engine& engine, std::vector<Input>& inputs) {
+  deadline = std::chrono::steady_clock::now() + settings.budget;
+  outOfTime = false;
+  salt += 0x9e3779b97f4a7c15ull;
+
+  const Block& block = engine.block();
+  sequence.assign(1, block.type);
+  for (int i = 0; i < Rules::PREVIEW; i++)
+    sequence.push_back(engine.getNext(i));
+  choices.clear();
+
+  Node root = { engine.getBoard(), engine.getHold(), 0, 0.0f, 0.0f, 0 };
+  beam.clear();
+
+  // room for more than a level usually holds, set aside by the first decision. a bigger level than that still
+  // makes them grow, after which they keep the room. beam and next trade buffers, so both get it.
+  beam.reserve(settings.beamWidth * LEVEL_RESERVE);
+  next.reserve(settings.beamWidth * LEVEL_RESERVE);
+  for (std::vector<Node>& list : children) list.reserve(settings.beamWidth * LEVEL_RESERVE);
+
+  // the first piece is searched from where it is now, so the inputs still work after gravity moved it.
+  roots[0].generate(root.board, block.type, block.x, block.y, block.rotation);
+
+  BlockType held = BlockType::None;
+  int heldNext = 1;
+  if (!engine.isHoldLocked()) {
+    if (root.hold != BlockType::None && root.hold != block.type) held = root.hold;
+    else if (root.hold == BlockType::None && sequence.size() > 1) {
+      held = sequence[1];
+      heldNext = 2;
+    }
+  }
+
+  if (held != BlockType::None) roots[1].generate(root.board, held);
+
+  for (int search = 0; search < (held != BlockType::None ? 2 : 1); search++) {
+    BlockType type = search == 0 ? block.type : held;
+    BlockType hold = search == 0 ? root.hold : block.type;
+    int next = search == 0 ? 1 : heldNext;
+
+    for (const Placement& placement : roots[search].all()) {
+      Node child;
+      if (!play(root, type, hold, next, placement, child)) continue;
+
+      child.root = choices.size();
+      choices.push_back({ search == 1, placement, search });
+      beam.push_back(child);
+    }
+  }
+
+  if (choices.empty()) {
+    inputs.assign(1, Input::HardDrop);
+    return;
+  }
+  score(beam, 0, *scratch[0]);
+
+  auto better = [](const Node& a, const Node& b) { return a.value > b.value; };
+  auto prune = [&](std::vector<Node>& nodes) {
+    if ((int)nodes.size() <= settings.beamWidth) return;
+    std::nth_element(nodes.begin(), nodes.begin() + settings.beamWidth, nodes.end(), better);
+    nodes.resize(settings.beamWidth);
+  };
+
+  prune(beam);
+
+  for (level = 1; !outOfTime; level++) {
+    for (std::vector<Node>& list : children) list.clear();
+
+    // only capturing this keeps the lambda small enough for std::function to hold without allocating.
+    pool.parallelFor(beam.size(), [this](int i) {
+      unsigned worker = TaskPool::worker();
+      expand(beam[i], level, children[worker], *scratch[worker]);
+    });
+
+    // a level that ran out of time is only partly expanded, so it can't be compared against the last one.
+    if (outOfTime) break;
+
+    next.clear();
+    for (std::vector<Node>& list : children)
+      next.insert(next.end(), list.begin(), list.end());
+
+    if (next.empty()) break;
+
+    prune(next);
+    beam.swap(next);
+  }
+
+  const Node& best = *std::max_element(beam.begin(), beam.end(), [](const Node& a, const Node& b) { return a.value < b.value; });
+  const Choice& choice = choices[best.root];
+
+  roots[choice.search].path(choice.placement, inputs);
+  if (choice.hold) inputs.insert(inputs.begin(), Input::Hold);
+}
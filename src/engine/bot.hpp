@@ -0,0 +1,95 @@
+#pragma once
+
+#include "engine.hpp"
+#include "evaluator.hpp"
+#include "placements.hpp"
+#include "task_pool.hpp"
+#include "transposition.hpp"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+// the board feature weights, and what each line cleared along the way is worth.
+struct BotWeights : EvalWeights {
+  float lines = 0.760666f;
+};
+
+struct BotSettings {
+  // boards kept after each piece.
+  int beamWidth = 128;
+  // how long decide() may search before it settles for the best line found so far.
+  std::chrono::microseconds budget = std::chrono::milliseconds(2);
+  BotWeights weights;
+};
+
+// beam search over the active block, hold and the preview.
+// each level of the beam is expanded across the task pool, and boards reached more than once
+// (through different orders or hold choices) are only kept once via a shared transposition table.
+class Bot {
+public:
+  explicit Bot(TaskPool& pool, BotSettings settings = {});
+
+  // picks where the active block should go, looking ahead through the preview,
+  // and fills inputs with the ones that take it there, starting with a hold when playing the held block instead is
+  // better. every buffer it searches with is kept between calls, so once they have grown a decision doesn't allocate.
+  void decide(const Engine& engine, std::vector<Input>& inputs);
+
+  float evaluate(const Board& board) const;
+private:
+  struct Node {
+    Board board;
+    BlockType hold;
+    // index of the next piece to play in the known sequence.
+    int next;
+    float reward;
+    float value;
+    // first move that led here.
+    int root;
+  };
+
+  // what each worker thread expands with.
+  struct Scratch {
+    Placements placements;
+    // the boards of the children just kept, scored together.
+    std::vector<const Board*> boards;
+    std::vector<float> scores;
+  };
+
+  struct Choice {
+    bool hold;
+    Placement placement;
+    // which of the root searches the placement came from.
+    int search;
+  };
+
+  void expand(const Node& node, int depth, std::vector<Node>& children, Scratch& scratch);
+  // sets value from reward for nodes[first] on.
+  void score(std::vector<Node>& nodes, size_t first, Scratch& scratch) const;
+  bool play(const Node& node, BlockType type, BlockType hold, int next, const Placement& placement, Node& child) const;
+  bool firstVisit(const Node& node, int depth);
+
+  TaskPool& pool;
+  BotSettings settings;
+  Evaluator evaluator;
+
+  std::vector<BlockType> sequence;
+  std::vector<Choice> choices;
+  Placements roots[2];
+  std::vector<std::unique_ptr<Scratch>> scratch;
+  // the level being expanded, what each worker made of it, and those gathered for pruning into the next level.
+  std::vector<Node> beam;
+  int level;
+  std::vector<std::vector<Node>> children;
+  std::vector<Node> next;
+  // nodes per beam node reserved in each of the lists above.
+  static constexpr int LEVEL_RESERVE = 16;
+
+  static constexpr size_t TABLE_SIZE = 1 << 16;
+  TranspositionTable table;
+  // changes every decision, so boards seen while making the last one don't count as seen.
+  uint64_t salt;
+
+  std::chrono::steady_clock::time_point deadline;
+  std::atomic<bool> outOfTime;
+};
@@ -0,0 +1,380 @@
+#include "engine.hpp"
+#include "pieces.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+template <int Columns, int Rows, int Hidden>
+BasicEngine<Columns, Rows, Hidden>::BasicEngine(uint64_t seed, Randomizer randomizer):
+  gameOver(false),
+  level(1),
+  score(0),
+  gravitySteps(Rules::GRAVITY_RATE),
+  linesCleared(0),
+  pieces(0),
+  tickRate(Rules::TICK_RATE),
+  lockDelay(0),
+  gravity(0),
+  fallen(0),
+  ticks(0),
+  lowest(Rows - 1),
+  timeReset(false),
+  timeResets(0),
+  timer(~0),
+  hold(BlockType::None),
+  holdLocked(false),
+  pendingGarbage(0),
+  attack(0),
+  holes(~seed),
+  generator(randomizer, seed),
+  previewStart(0)
+{
+  reset();
+}
+
+template <int Columns, int Rows, int Hidden>
+void BasicEngine<Columns, Rows, Hidden>::seed(uint64_t value) {
+  generator.seed(value);
+  holes.seed(~value);
+}
+
+template <int Columns, int Rows, int Hidden>
+void BasicEngine<Columns, Rows, Hidden>::reset() {
+  gameOver = false;
+  level = 1;
+  score = 0;
+  gravitySteps = Rules::GRAVITY_RATE;
+  linesCleared = 0;
+  pieces = 0;
+  ticks = 0;
+  fallen = 0;
+  updateTimings();
+  resetTimers();
+  hold = BlockType::None;
+  holdLocked = false;
+  pendingGarbage = 0;
+  attack = 0;
+
+  board.clear();
+
+  generator.reset();
+  for (BlockType& block : preview)
+    block = generator.next();
+  previewStart = 0;
+
+  spawnBlock();
+}
+
+template <int Columns, int Rows, int Hidden>
+void BasicEngine<Columns, Rows, Hidden>::setTickRate(int rate) {
+  tickRate = std::max(1, rate);
+  updateTimings();
+}
+
+template <int Columns, int Rows, int Hidden>
+void BasicEngine<Columns, Rows, Hidden>::updateTimings() {
+  lockDelay = toTicks(Rules::LOCK_DELAY);
+
+  // once the curve reaches zero the block falls every step, and past level 30 by more than a row at a time.
+  double rowsPerSecond = gravitySteps > 0
+    ? double(Rules::GRAVITY_RATE) / gravitySteps
+    : double(Rules::GRAVITY_RATE) * std::max(1, level - 30);
+
+  // rounded up, so a row never takes a tick longer than it should.
+  gravity = uint32_t(std::ceil(rowsPerSecond * 65536 / tickRate));
+}
+
+template <int Columns, int Rows, int Hidden>
+bool BasicEngine<Columns, Rows, Hidden>::tick() {
+  if (gameOver) return false;
+
+  ticks++;
+
+  // a timer of ~0 means the block never got below the top row of the field, so it locks straight away.
+  if (!blockCanDrop() && (timer == ~0ull || ticks - timer >= (uint64_t)lockDelay)) {
+    if (timeReset) timeResets++;
+
+    if (!timeReset || timeResets == Rules::LOCK_RESETS) {
+      if (!lock()) return false;
+    } else timer = ticks;
+
+    timeReset = false;
+  }
+
+  fallen += gravity;
+
+  if (fallen >> 16) {
+    drop(std::min<int>(fallen >> 16, dropDistance()));
+    fallen &= 0xffff;
+
+    if (activeBlock.y < lowest) {
+      lowest = activeBlock.y;
+      timer = ticks;
+    }
+  }
+
+  return true;
+}
+
+template <int Columns, int Rows, int Hidden>
+bool BasicEngine<Columns, Rows, Hidden>::input(Input command) {
+  if (gameOver) return false;
+
+  switch (command) {
+    case Input::MoveLeft:
+      return moveHorizontal(-1);
+    case Input::MoveRight:
+      return moveHorizontal(1);
+    case Input::SoftDrop:
+      if (!moveDown()) return false;
+      fallen = 0;
+      return true;
+    case Input::HardDrop:
+      drop(dropDistance());
+      lock();
+      return true;
+    case Input::RotateClockwise:
+      return rotate(1);
+    case Input::RotateCounterclockwise:
+      return rotate(-1);
+    case Input::Hold:
+      if (holdLocked) return false;
+
+      if (hold != BlockType::None) {
+        BlockType before = activeBlock.type;
+        spawnBlock(hold);
+        hold = before;
+      } else {
+        hold = activeBlock.type;
+        spawnBlock();
+      }
+
+      holdLocked = true;
+      return true;
+  }
+
+  return false;
+}
+
+template <int Columns, int Rows, int Hidden>
+bool BasicEngine<Columns, Rows, Hidden>::lock() {
+  if (!place()) {
+    gameOver = true;
+    return false;
+  }
+
+  resetTimers();
+  spawnBlock();
+  return !gameOver;
+}
+
+template <int Columns, int Rows, int Hidden>
+void BasicEngine<Columns, Rows, Hidden>::addGarbage(int lines) {
+  pendingGarbage = std::min(pendingGarbage + lines, Rows + Hidden);
+}
+
+template <int Columns, int Rows, int Hidden>
+int BasicEngine<Columns, Rows, Hidden>::takeAttack() {
+  int sent = attack;
+  attack = 0;
+  return sent;
+}
+
+template <int Columns, int Rows, int Hidden>
+bool BasicEngine<Columns, Rows, Hidden>::blockCanDrop(const Block& block, const Board& board) {
+  return board.fits(Pieces::cells(block, 0, -1));
+}
+
+template <int Columns, int Rows, int Hidden>
+BlockType BasicEngine<Columns, Rows, Hidden>::takeNext() {
+  BlockType next = preview[previewStart];
+
+  preview[previewStart] = generator.next();
+  previewStart = (previewStart + 1) % Rules::PREVIEW;
+
+  return next;
+}
+
+template <int Columns, int Rows, int Hidden>
+bool BasicEngine<Columns, Rows, Hidden>::blockCanDrop() const {
+  return blockCanDrop(activeBlock, board);
+}
+
+template <int Columns, int Rows, int Hidden>
+bool BasicEngine<Columns, Rows, Hidden>::moveDown() {
+  if (!blockCanDrop()) return false;
+
+  activeBlock.y--;
+  return true;
+}
+
+template <int Columns, int Rows, int Hidden>
+bool BasicEngine<Columns, Rows, Hidden>::moveHorizontal(int direction) {
+  if (!board.fits(Pieces::cells(activeBlock, direction, 0))) return false;
+
+  activeBlock.x += direction;
+
+  timeReset = true;
+  return true;
+}
+
+template <int Columns, int Rows, int Hidden>
+bool BasicEngine<Columns, Rows, Hidden>::rotate(int direction) {
+  if (activeBlock.type == BlockType::O) return false;
+
+  int from = activeBlock.rotation;
+  int to = (from + direction + Pieces::ROTATIONS) % Pieces::ROTATIONS;
+
+  const Pieces::Shape& shape = Pieces::SHAPES[activeBlock.type][to];
+
+  for (const Pieces::Offset& kick : Pieces::KICKS[activeBlock.type][from][to]) {
+    if (!board.fits(Pieces::cells(shape, activeBlock.x + kick.x, activeBlock.y + kick.y))) continue;
+
+    activeBlock.x += kick.x;
+    activeBlock.y += kick.y;
+    activeBlock.rotation = to;
+
+    timeReset = true;
+    return true;
+  }
+
+  return false;
+}
+
+template <int Columns, int Rows, int Hidden>
+int BasicEngine<Columns, Rows, Hidden>::dropDistance() const {
+  std::array<Coords, 4> tiles = Pieces::cells(activeBlock);
+  int distance = Board::HEIGHT;
+  bool covered = false;
+
+  // everything above the skyline is empty, so a block wholly above it falls straight onto it.
+  for (const Coords& tile : tiles) {
+    int gap = tile.y - board.height(tile.x);
+    covered |= gap < 0;
+    distance = std::min(distance, gap);
+  }
+
+  if (!covered) return distance;
+
+  // tucked under part of the stack, where the skyline says nothing about what's below, so step down a row at a time.
+  distance = 0;
+  while (board.fits(Pieces::cells(activeBlock, 0, -(distance + 1)))) distance++;
+  return distance;
+}
+
+template <int Columns, int Rows, int Hidden>
+void BasicEngine<Columns, Rows, Hidden>::drop(int rows) {
+  activeBlock.y -= rows;
+}
+
+template <int Columns, int Rows, int Hidden>
+Coords BasicEngine<Columns, Rows, Hidden>::endLocation() const {
+  return { activeBlock.x, activeBlock.y - dropDistance() };
+}
+
+template <int Columns, int Rows, int Hidden>
+bool BasicEngine<Columns, Rows, Hidden>::place() {
+  std::array<Coords, 4> tiles = Pieces::cells(activeBlock);
+
+  // the stack has topped out if the block would lock wholly out of sight, or past the hidden rows.
+  bool hidden = true;
+  for (const Coords& tile : tiles) {
+    if (tile.y >= Rows + Hidden) return false;
+    hidden &= tile.y >= Rows;
+  }
+
+  if (hidden) return false;
+
+  for (const Coords& tile : tiles)
+    board.set(tile.x, tile.y, activeBlock.type);
+
+  // clear lines
+
+  int cleared = board.clearLines();
+  linesCleared += cleared;
+  pieces++;
+
+  switch (cleared) {
+    case 1: score += 100; break;
+    case 2: score += 300; break;
+    case 3: score += 500; break;
+    case 4: score += 800; break;
+    default: break;
+  }
+
+  int levelBefore = level;
+  level = linesCleared / 5 + 1;
+  if (level != levelBefore) {
+    gravitySteps = gravitySteps * (1.0f - 0.1f);
+    updateTimings();
+  }
+
+  if (cleared > 0) {
+    int sent = Versus::ATTACK[cleared];
+    int cancelled = std::min(sent, pendingGarbage);
+    pendingGarbage -= cancelled;
+    attack += sent - cancelled;
+  } else if (pendingGarbage > 0) {
+    int lines = pendingGarbage;
+    pendingGarbage = 0;
+    if (!board.rise(lines, holes.below(Columns))) return false;
+  }
+
+  fallen = 0;
+  holdLocked = false;
+  return true;
+}
+
+template <int Columns, int Rows, int Hidden>
+void BasicEngine<Columns, Rows, Hidden>::spawnBlock(BlockType type) {
+  activeBlock.type = type != BlockType::None ? type : takeNext();
+
+  Coords spawn = spawnLocation(board, activeBlock.type);
+  activeBlock.x = spawn.x;
+  activeBlock.y = spawn.y;
+  activeBlock.rotation = 0;
+
+  // the game is also over once there's no room left to spawn into.
+  if (!board.fits(Pieces::cells(activeBlock))) gameOver = true;
+}
+
+template <int Columns, int Rows, int Hidden>
+Coords BasicEngine<Columns, Rows, Hidden>::spawnLocation(const Board& board, BlockType type) {
+  int height = std::max(board.stackHeight() - 1, 0);
+
+  int heightOffset = 0;
+  if (height >= Rows - 1) heightOffset = 3;
+  else if (height >= Rows - 4) heightOffset = 1;
+
+  return { Columns / 2 - 1 + Pieces::SPAWN_COLUMNS[type], Rows - 2 + heightOffset };
+}
+
+// a bool copied in as raw bytes can hold any value, and loading one that isn't 0 or 1 is undefined, so its byte is
+// looked at instead.
+static inline bool isBool(const bool& value) {
+  uint8_t byte;
+  memcpy(&byte, &value, 1);
+  return byte <= 1;
+}
+
+template <int Columns, int Rows, int Hidden>
+bool BasicEngine<Columns, Rows, Hidden>::valid() const {
+  auto dealt = [](BlockType block) { return block >= BlockType::I && block <= BlockType::Z; };
+
+  if (!isBool(gameOver) || !isBool(timeReset) || !isBool(holdLocked)) return false;
+  if (!dealt(activeBlock.type) || activeBlock.rotation < 0 || activeBlock.rotation >= Pieces::ROTATIONS) return false;
+
+  // the block may be out of sight above the field, but never past the sky or outside the walls.
+  for (const Coords& tile : Pieces::cells(activeBlock))
+    if (tile.x < 0 || tile.x >= Columns || tile.y < 0 || tile.y >= Rows + Hidden + Board::SKY) return false;
+
+  return (hold == BlockType::None || dealt(hold))
+    && std::all_of(preview.begin(), preview.end(), dealt)
+    && previewStart >= 0 && previewStart < Rules::PREVIEW
+    && tickRate > 0
+    && board.valid() && generator.valid();
+}
+
+template class BasicEngine<COLUMNS, ROWS, HIDDEN_ROWS>;
+template class BasicEngine<COLUMNS * 2, ROWS, HIDDEN_ROWS>;
+template class BasicEngine<COLUMNS, ROWS * 2, HIDDEN_ROWS>;
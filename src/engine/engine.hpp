@@ -0,0 +1,165 @@
+#pragma once
+
+#include "../constants.hpp"
+#include "../array.hpp"
+#include "block.hpp"
+#include "board.hpp"
+#include "randomizer.hpp"
+#include <algorithm>
+#include <cstdint>
+
+// commands the engine understands. front-ends and bots translate whatever they
+// receive (keyboard, network, search results) into these.
+enum Input {
+  MoveLeft,
+  MoveRight,
+  SoftDrop,
+  HardDrop,
+  RotateClockwise,
+  RotateCounterclockwise,
+  Hold
+};
+
+// the rules of the game, without any windowing or timing of its own.
+// everything advances through tick() and input(), so it can be stepped as fast as the caller likes.
+// the field is Columns x Rows on screen, with Hidden more rows above it that blocks spawn into and may lock in.
+// the sizes in use are instantiated in engine.cpp; Engine is the standard one.
+template <int Columns, int Rows, int Hidden>
+class BasicEngine {
+public:
+  using Board = BasicBoard<Columns, Rows + Hidden>;
+
+  static constexpr int COLUMNS = Columns;
+  static constexpr int ROWS = Rows;
+  static constexpr int HIDDEN_ROWS = Hidden;
+
+  explicit BasicEngine(uint64_t seed = 0, Randomizer randomizer = Randomizer::Bag);
+
+  // restarts the piece sequence. games started from the same seed and randomizer get the same blocks.
+  void seed(uint64_t value);
+  // takes effect from the next reset().
+  inline void setRandomizer(Randomizer mode) { generator.setMode(mode); }
+  void reset();
+
+  // ticks per second. timings are converted right away, so this can change mid-game.
+  void setTickRate(int rate);
+  inline int getTickRate() const { return tickRate; }
+  // milliseconds to whole ticks at the current rate, never less than one.
+  inline int toTicks(int milliseconds) const { return std::max(1, milliseconds * tickRate / 1000); }
+  // rows per second the active block falls on its own at the current level.
+  inline double getFallSpeed() const { return double(gravity) * tickRate / 65536; }
+
+  // advances the game by one tick (gravity and lock delay). returns false once the game is over.
+  bool tick();
+  // applies a single player command. returns false if it had no effect.
+  bool input(Input command);
+
+  bool blockCanDrop() const;
+  bool moveDown();
+  // 1 = right, -1 = left
+  bool moveHorizontal(int direction);
+  // 1 = clockwise, -1 = counterclockwise
+  bool rotate(int direction);
+
+  // where the active block's origin lands if dropped.
+  Coords endLocation() const;
+
+  bool place();
+
+  void spawnBlock(BlockType type = BlockType::None);
+  // garbage from an opponent. it rises from the floor when the active block next locks without clearing a line,
+  // and lines cleared before then cancel it instead of being sent back.
+  void addGarbage(int lines);
+  // garbage lines this side's clears have sent since the last call.
+  int takeAttack();
+  inline int getPendingGarbage() const { return pendingGarbage; }
+
+  // swaps in a different stack, e.g. to set up puzzles or benchmarks. the active block stays where it is,
+  // so follow with spawnBlock() unless it is known to fit.
+  inline void setBoard(const Board& value) { board = value; }
+
+  // tile the origin of a new block of the given type starts on, which depends on how high the stack is.
+  static Coords spawnLocation(const Board& board, BlockType type);
+
+  inline bool over() const { return gameOver; }
+  inline const Block& block() const { return activeBlock; }
+  inline const Board& getBoard() const { return board; }
+  inline int getLevel() const { return level; }
+  inline int getScore() const { return score; }
+  inline int getLinesCleared() const { return linesCleared; }
+  inline int getPieces() const { return pieces; }
+  inline BlockType getHold() const { return hold; }
+  // the i-th block to come after the active one, for i < Rules::PREVIEW.
+  inline BlockType getNext(int i) const { return preview[(previewStart + i) % Rules::PREVIEW]; }
+  inline bool isHoldLocked() const { return holdLocked; }
+  inline uint64_t getTicks() const { return ticks; }
+
+  // Zobrist hash of the position: the stack, the active block, the held block and whether hold is used up.
+  // the same position reached through different inputs hashes the same. the board keeps its share up to date as
+  // tiles come and go, and the rest is a few table lookups, so asking costs next to nothing.
+  inline uint64_t hash() const {
+    return board.hash() ^ Zobrist::block(activeBlock) ^ Zobrist::HOLD[hold] ^ (holdLocked ? Zobrist::HOLD_LOCKED : 0);
+  }
+
+  // whether every field the rules look tables up with (block types, rotation, position, the preview ring) is in range,
+  // the board is consistent with itself and the tick rate can be divided by. always true of an engine played through
+  // the calls above; for checking one copied in as raw bytes, like a replay keyframe, before stepping or drawing it.
+  bool valid() const;
+private:
+  static bool blockCanDrop(const Block& block, const Board& board);
+  // rows the active block can fall before it lands.
+  int dropDistance() const;
+  // moves the active block down by rows without checking they are free.
+  void drop(int rows);
+
+  bool lock();
+  BlockType takeNext();
+  void updateTimings();
+
+  bool gameOver;
+
+  Block activeBlock;
+  Board board;
+  int level;
+  int score;
+  // see Rules::GRAVITY_RATE.
+  int gravitySteps;
+  int linesCleared;
+  int pieces;
+
+  int tickRate;
+  int lockDelay;
+  // rows fallen per tick, and the fraction of a row fallen since the last one, both in 1/65536ths of a row.
+  uint32_t gravity;
+  uint32_t fallen;
+
+  uint64_t ticks;
+  // lowest row the block has reached since the last lock. it starts at the top row of the field, so a block
+  // that never gets any lower than that locks as soon as it lands.
+  int lowest;
+  bool timeReset;
+  int timeResets;
+  uint64_t timer;
+  inline void resetTimers() {
+    lowest = Rows - 1;
+    timeReset = false;
+    timeResets = 0;
+    timer = ~0;
+  };
+
+  BlockType hold;
+  bool holdLocked;
+
+  // garbage waiting to rise and garbage sent, see addGarbage() and takeAttack(). the column left open in each batch
+  // of garbage comes from its own generator, so versus play doesn't change the block sequence.
+  int pendingGarbage;
+  int attack;
+  Xoshiro256 holes;
+
+  PieceGenerator generator;
+  // ring buffer of upcoming blocks, starting at previewStart.
+  std::array<BlockType, Rules::PREVIEW> preview;
+  int previewStart;
+};
+
+using Engine = BasicEngine<COLUMNS, ROWS, HIDDEN_ROWS>;
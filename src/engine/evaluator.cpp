@@ -0,0 +1,414 @@
+#include "evaluator.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdlib>
+
+#if defined(__x86_64__)
+#define EVALUATOR_X86
+#include <immintrin.h>
+#endif
+
+// wells are measured against the walls as if they were this tall.
+static constexpr int WALL_HEIGHT = 0xff;
+// pairs of neighbouring bits a row transition can sit between, from the left wall to the right one.
+static constexpr Board::Row EDGES = ((Board::Row(1) << (COLUMNS + 1)) - 1) << (Board::WALL - 1);
+
+static inline float combine(const EvalWeights& weights, const BoardFeatures& features) {
+  return weights.height * features.height + weights.holes * features.holes + weights.bumpiness * features.bumpiness
+    + weights.rowTransitions * features.rowTransitions + weights.columnTransitions * features.columnTransitions
+    + weights.wells * features.wells;
+}
+
+[[gnu::always_inline]] static inline void heightFeatures(const Board& board, BoardFeatures& out) {
+  out.height = out.bumpiness = out.wells = 0;
+
+  for (int x = 0; x < COLUMNS; x++) {
+    int height = board.height(x);
+    int left = x > 0 ? board.height(x - 1) : WALL_HEIGHT;
+    int right = x + 1 < COLUMNS ? board.height(x + 1) : WALL_HEIGHT;
+
+    out.height += height;
+    if (x > 0) out.bumpiness += std::abs(height - left);
+    out.wells += std::max(0, std::min(left, right) - height);
+  }
+}
+
+// always inlined, so inside a kernel built for popcnt the counts become that instruction.
+[[gnu::always_inline]] static inline void rowFeatures(const Board& board, BoardFeatures& out) {
+  const Board::Row* rows = board.rowData();
+  int top = board.stackHeight();
+  int filled = 0;
+  out.rowTransitions = out.columnTransitions = 0;
+
+  for (int y = 0; y < top; y++) {
+    Board::Row row = rows[y];
+    filled += std::popcount(row & Board::FIELD);
+    out.rowTransitions += std::popcount((row ^ row >> 1) & EDGES);
+  }
+
+  // up to the empty row on top of the stack, so every column's surface counts too.
+  for (int y = 0; y <= top; y++)
+    out.columnTransitions += std::popcount((rows[y] ^ rows[y - 1]) & Board::FIELD);
+
+  // everything filled is under its column's height, so whatever else is under it is a hole.
+  out.holes = out.height - filled;
+}
+
+static BoardFeatures featuresScalar(const Board& board) {
+  BoardFeatures out;
+  heightFeatures(board, out);
+  rowFeatures(board, out);
+  return out;
+}
+
+static void scoreScalar(const EvalWeights& weights, const Board* const* boards, float* scores, int count) {
+  for (int i = 0; i < count; i++) scores[i] = combine(weights, featuresScalar(*boards[i]));
+}
+
+#ifdef EVALUATOR_X86
+
+static_assert(COLUMNS < 16, "column heights are scored in one 16 byte vector");
+static_assert(sizeof(Board::Row) == 4, "rows are loaded eight to a 32 byte vector");
+static_assert(Board::SKY >= 8, "the last load may reach 8 rows past the stack");
+
+// a 16 byte mask, 0xff in lanes [first, last).
+static constexpr std::array<uint8_t, 16> lanes(int first, int last) {
+  std::array<uint8_t, 16> mask = {};
+  for (int i = first; i < last; i++) mask[i] = 0xff;
+  return mask;
+}
+
+static constexpr std::array<uint8_t, 16> PAIRS = lanes(0, COLUMNS - 1);
+static constexpr std::array<uint8_t, 16> LEFT_WALL = lanes(0, 1);
+static constexpr std::array<uint8_t, 16> RIGHT_WALL = lanes(COLUMNS - 1, COLUMNS);
+
+static inline __m128i load(const std::array<uint8_t, 16>& mask) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask.data()));
+}
+
+// the sum of |a - b| over the 16 byte lanes.
+static inline int sumDifferences(__m128i a, __m128i b) {
+  __m128i sums = _mm_sad_epu8(a, b);
+  return _mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4);
+}
+
+// a byte per column, so all of them are compared against their neighbours at once. SSE2, which every x86-64 has.
+[[gnu::always_inline]] static inline void heightFeaturesSse(const Board& board, BoardFeatures& out) {
+  alignas(16) uint8_t bytes[16] = {};
+  for (int x = 0; x < COLUMNS; x++) bytes[x] = uint8_t(board.height(x));
+
+  __m128i heights = _mm_load_si128(reinterpret_cast<const __m128i*>(bytes));
+  __m128i left = _mm_or_si128(_mm_slli_si128(heights, 1), load(LEFT_WALL));
+  __m128i right = _mm_or_si128(_mm_srli_si128(heights, 1), load(RIGHT_WALL));
+
+  __m128i pairs = load(PAIRS);
+  __m128i zero = _mm_setzero_si128();
+
+  out.height = sumDifferences(heights, zero);
+  out.bumpiness = sumDifferences(_mm_and_si128(heights, pairs), _mm_and_si128(right, pairs));
+  // saturating, so columns above their lower neighbour count as 0.
+  out.wells = sumDifferences(_mm_subs_epu8(_mm_min_epu8(left, right), heights), zero);
+}
+
+__attribute__((target("sse4.2,popcnt")))
+static BoardFeatures featuresSse4(const Board& board) {
+  BoardFeatures out;
+  heightFeaturesSse(board, out);
+  rowFeatures(board, out);
+  return out;
+}
+
+// bits set in each 32 bit lane of v: a table lookup per nibble, then each lane's four bytes added up.
+__attribute__((target("sse4.2")))
+static inline __m128i popcountLanes(__m128i v) {
+  const __m128i table = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m128i nibbles = _mm_set1_epi8(0x0f);
+
+  __m128i low = _mm_shuffle_epi8(table, _mm_and_si128(v, nibbles));
+  __m128i high = _mm_shuffle_epi8(table, _mm_and_si128(_mm_srli_epi16(v, 4), nibbles));
+  __m128i pairs = _mm_maddubs_epi16(_mm_add_epi8(low, high), _mm_set1_epi8(1));
+  return _mm_madd_epi16(pairs, _mm_set1_epi16(1));
+}
+
+// row y of each of four boards, a lane each.
+__attribute__((target("sse4.2")))
+static inline __m128i gatherRows(const Board::Row* const* rows, int y) {
+  return _mm_setr_epi32(int(rows[0][y]), int(rows[1][y]), int(rows[2][y]), int(rows[3][y]));
+}
+
+// the same weighted sum as combine(), in the same order, so lanes score exactly what one board at a time would.
+__attribute__((target("sse4.2")))
+static inline __m128 combineLanes(const EvalWeights& weights, __m128i height, __m128i holes, __m128i bumpiness,
+                                  __m128i rowTransitions, __m128i columnTransitions, __m128i wells) {
+  __m128 score = _mm_mul_ps(_mm_set1_ps(weights.height), _mm_cvtepi32_ps(height));
+  score = _mm_add_ps(score, _mm_mul_ps(_mm_set1_ps(weights.holes), _mm_cvtepi32_ps(holes)));
+  score = _mm_add_ps(score, _mm_mul_ps(_mm_set1_ps(weights.bumpiness), _mm_cvtepi32_ps(bumpiness)));
+  score = _mm_add_ps(score, _mm_mul_ps(_mm_set1_ps(weights.rowTransitions), _mm_cvtepi32_ps(rowTransitions)));
+  score = _mm_add_ps(score, _mm_mul_ps(_mm_set1_ps(weights.columnTransitions), _mm_cvtepi32_ps(columnTransitions)));
+  return _mm_add_ps(score, _mm_mul_ps(_mm_set1_ps(weights.wells), _mm_cvtepi32_ps(wells)));
+}
+
+// column x of each of four boards.
+__attribute__((target("sse4.2")))
+static inline __m128i gatherHeights(const Board* const* boards, int x) {
+  return _mm_setr_epi32(boards[0]->height(x), boards[1]->height(x), boards[2]->height(x), boards[3]->height(x));
+}
+
+// four boards at once, a 32 bit lane each: a column of all four per step, then a row of all four per step up to the
+// tallest stack. rows above a board's stack are empty, so they add nothing but the walls to its row transitions,
+// which are masked out.
+__attribute__((target("sse4.2,popcnt")))
+static void scoreFourSse4(const EvalWeights& weights, const Board* const* boards, float* scores) {
+  const Board::Row* rows[4];
+  alignas(16) int tops[4];
+  int top = 0;
+
+  for (int lane = 0; lane < 4; lane++) {
+    rows[lane] = boards[lane]->rowData();
+    tops[lane] = boards[lane]->stackHeight();
+    top = std::max(top, tops[lane]);
+  }
+
+  const __m128i wall = _mm_set1_epi32(WALL_HEIGHT);
+  __m128i left = wall, middle = gatherHeights(boards, 0);
+  __m128i heights = middle, bumps = _mm_setzero_si128(), deep = _mm_setzero_si128();
+
+  for (int x = 0; x < COLUMNS; x++) {
+    __m128i right = x + 1 < COLUMNS ? gatherHeights(boards, x + 1) : wall;
+    if (x + 1 < COLUMNS) {
+      heights = _mm_add_epi32(heights, right);
+      bumps = _mm_add_epi32(bumps, _mm_abs_epi32(_mm_sub_epi32(right, middle)));
+    }
+    deep = _mm_add_epi32(deep, _mm_max_epi32(_mm_sub_epi32(_mm_min_epi32(left, right), middle), _mm_setzero_si128()));
+    left = middle;
+    middle = right;
+  }
+
+  const __m128i field = _mm_set1_epi32(int(Board::FIELD));
+  const __m128i edges = _mm_set1_epi32(int(EDGES));
+  const __m128i limit = _mm_load_si128(reinterpret_cast<const __m128i*>(tops));
+
+  __m128i filled = _mm_setzero_si128(), across = _mm_setzero_si128(), down = _mm_setzero_si128();
+  __m128i below = gatherRows(rows, -1);
+
+  for (int y = 0; y <= top; y++) {
+    __m128i row = gatherRows(rows, y);
+    __m128i live = _mm_cmpgt_epi32(limit, _mm_set1_epi32(y));
+
+    filled = _mm_add_epi32(filled, popcountLanes(_mm_and_si128(row, field)));
+    __m128i changes = _mm_xor_si128(row, _mm_srli_epi32(row, 1));
+    across = _mm_add_epi32(across, popcountLanes(_mm_and_si128(_mm_and_si128(changes, edges), live)));
+    down = _mm_add_epi32(down, popcountLanes(_mm_and_si128(_mm_xor_si128(row, below), field)));
+    below = row;
+  }
+
+  __m128i holes = _mm_sub_epi32(heights, filled);
+  _mm_storeu_ps(scores, combineLanes(weights, heights, holes, bumps, across, down, deep));
+}
+
+__attribute__((target("sse4.2,popcnt")))
+static void scoreSse4(const EvalWeights& weights, const Board* const* boards, float* scores, int count) {
+  int i = 0;
+  for (; i + 4 <= count; i += 4) scoreFourSse4(weights, boards + i, scores + i);
+  for (; i < count; i++) scores[i] = combine(weights, featuresSse4(*boards[i]));
+}
+
+// bits set in each 32 bit lane of v, summed into its four 64 bit lanes. a table lookup per nibble, as AVX2 has
+// no popcount of its own.
+__attribute__((target("avx2")))
+static inline __m256i popcount(__m256i v) {
+  const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i nibbles = _mm256_set1_epi8(0x0f);
+
+  __m256i low = _mm256_shuffle_epi8(table, _mm256_and_si256(v, nibbles));
+  __m256i high = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibbles));
+  return _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2")))
+static inline int sumLanes(__m256i v) {
+  __m128i half = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+  return int(_mm_cvtsi128_si64(half) + _mm_extract_epi64(half, 1));
+}
+
+// eight rows per step. rows above the stack are empty, so they add nothing to the filled count or the column
+// transitions, and are masked out of the row transitions, which would count their walls.
+__attribute__((target("avx2,popcnt")))
+static BoardFeatures featuresAvx2(const Board& board) {
+  BoardFeatures out;
+  heightFeaturesSse(board, out);
+
+  const Board::Row* rows = board.rowData();
+  int top = board.stackHeight();
+
+  const __m256i field = _mm256_set1_epi32(int(Board::FIELD));
+  const __m256i edges = _mm256_set1_epi32(int(EDGES));
+  const __m256i offsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i limit = _mm256_set1_epi32(top);
+
+  __m256i filled = _mm256_setzero_si256(), across = _mm256_setzero_si256(), down = _mm256_setzero_si256();
+
+  for (int y = 0; y <= top; y += 8) {
+    __m256i row = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows + y));
+    __m256i below = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows + y - 1));
+    __m256i live = _mm256_cmpgt_epi32(limit, _mm256_add_epi32(offsets, _mm256_set1_epi32(y)));
+
+    filled = _mm256_add_epi64(filled, popcount(_mm256_and_si256(row, field)));
+    __m256i changes = _mm256_xor_si256(row, _mm256_srli_epi32(row, 1));
+    across = _mm256_add_epi64(across, popcount(_mm256_and_si256(_mm256_and_si256(changes, edges), live)));
+    down = _mm256_add_epi64(down, popcount(_mm256_and_si256(_mm256_xor_si256(row, below), field)));
+  }
+
+  out.holes = out.height - sumLanes(filled);
+  out.rowTransitions = sumLanes(across);
+  out.columnTransitions = sumLanes(down);
+  return out;
+}
+
+// popcountLanes() over eight lanes.
+__attribute__((target("avx2")))
+static inline __m256i popcountLanes(__m256i v) {
+  const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i nibbles = _mm256_set1_epi8(0x0f);
+
+  __m256i low = _mm256_shuffle_epi8(table, _mm256_and_si256(v, nibbles));
+  __m256i high = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibbles));
+  __m256i pairs = _mm256_maddubs_epi16(_mm256_add_epi8(low, high), _mm256_set1_epi8(1));
+  return _mm256_madd_epi16(pairs, _mm256_set1_epi16(1));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i gatherRows8(const Board::Row* const* rows, int y) {
+  return _mm256_setr_epi32(int(rows[0][y]), int(rows[1][y]), int(rows[2][y]), int(rows[3][y]),
+                           int(rows[4][y]), int(rows[5][y]), int(rows[6][y]), int(rows[7][y]));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i gatherHeights8(const Board* const* boards, int x) {
+  return _mm256_setr_epi32(boards[0]->height(x), boards[1]->height(x), boards[2]->height(x), boards[3]->height(x),
+                           boards[4]->height(x), boards[5]->height(x), boards[6]->height(x), boards[7]->height(x));
+}
+
+// scoreFourSse4() over eight boards.
+__attribute__((target("avx2,popcnt")))
+static void scoreEightAvx2(const EvalWeights& weights, const Board* const* boards, float* scores) {
+  const Board::Row* rows[8];
+  alignas(32) int tops[8];
+  int top = 0;
+
+  for (int lane = 0; lane < 8; lane++) {
+    rows[lane] = boards[lane]->rowData();
+    tops[lane] = boards[lane]->stackHeight();
+    top = std::max(top, tops[lane]);
+  }
+
+  const __m256i wall = _mm256_set1_epi32(WALL_HEIGHT);
+  __m256i left = wall, middle = gatherHeights8(boards, 0);
+  __m256i heights = middle, bumps = _mm256_setzero_si256(), deep = _mm256_setzero_si256();
+
+  for (int x = 0; x < COLUMNS; x++) {
+    __m256i right = x + 1 < COLUMNS ? gatherHeights8(boards, x + 1) : wall;
+    if (x + 1 < COLUMNS) {
+      heights = _mm256_add_epi32(heights, right);
+      bumps = _mm256_add_epi32(bumps, _mm256_abs_epi32(_mm256_sub_epi32(right, middle)));
+    }
+    deep = _mm256_add_epi32(deep, _mm256_max_epi32(_mm256_sub_epi32(_mm256_min_epi32(left, right), middle),
+                                                   _mm256_setzero_si256()));
+    left = middle;
+    middle = right;
+  }
+
+  const __m256i field = _mm256_set1_epi32(int(Board::FIELD));
+  const __m256i edges = _mm256_set1_epi32(int(EDGES));
+  const __m256i limit = _mm256_load_si256(reinterpret_cast<const __m256i*>(tops));
+
+  __m256i filled = _mm256_setzero_si256(), across = _mm256_setzero_si256(), down = _mm256_setzero_si256();
+  __m256i below = gatherRows8(rows, -1);
+
+  for (int y = 0; y <= top; y++) {
+    __m256i row = gatherRows8(rows, y);
+    __m256i live = _mm256_cmpgt_epi32(limit, _mm256_set1_epi32(y));
+
+    filled = _mm256_add_epi32(filled, popcountLanes(_mm256_and_si256(row, field)));
+    __m256i changes = _mm256_xor_si256(row, _mm256_srli_epi32(row, 1));
+    across = _mm256_add_epi32(across, popcountLanes(_mm256_and_si256(_mm256_and_si256(changes, edges), live)));
+    down = _mm256_add_epi32(down, popcountLanes(_mm256_and_si256(_mm256_xor_si256(row, below), field)));
+    below = row;
+  }
+
+  __m256i holes = _mm256_sub_epi32(heights, filled);
+
+  // the sum is taken in the same order as combine().
+  __m256 score = _mm256_mul_ps(_mm256_set1_ps(weights.height), _mm256_cvtepi32_ps(heights));
+  score = _mm256_add_ps(score, _mm256_mul_ps(_mm256_set1_ps(weights.holes), _mm256_cvtepi32_ps(holes)));
+  score = _mm256_add_ps(score, _mm256_mul_ps(_mm256_set1_ps(weights.bumpiness), _mm256_cvtepi32_ps(bumps)));
+  score = _mm256_add_ps(score, _mm256_mul_ps(_mm256_set1_ps(weights.rowTransitions), _mm256_cvtepi32_ps(across)));
+  score = _mm256_add_ps(score, _mm256_mul_ps(_mm256_set1_ps(weights.columnTransitions), _mm256_cvtepi32_ps(down)));
+  score = _mm256_add_ps(score, _mm256_mul_ps(_mm256_set1_ps(weights.wells), _mm256_cvtepi32_ps(deep)));
+  _mm256_storeu_ps(scores, score);
+}
+
+__attribute__((target("avx2,popcnt")))
+static void scoreAvx2(const EvalWeights& weights, const Board* const* boards, float* scores, int count) {
+  int i = 0;
+  for (; i + 8 <= count; i += 8) scoreEightAvx2(weights, boards + i, scores + i);
+  for (; i < count; i++) scores[i] = combine(weights, featuresAvx2(*boards[i]));
+}
+
+#endif
+
+Evaluator::Evaluator(const EvalWeights& weights, Kernel kernel): weights(weights) {
+  active = Kernel(std::min<int>(kernel, best()));
+
+  switch (active) {
+#ifdef EVALUATOR_X86
+    case Kernel::Avx2:
+      featuresFn = featuresAvx2;
+      scoreFn = scoreAvx2;
+      break;
+    case Kernel::Sse4:
+      featuresFn = featuresSse4;
+      scoreFn = scoreSse4;
+      break;
+#endif
+    default:
+      featuresFn = featuresScalar;
+      scoreFn = scoreScalar;
+  }
+}
+
+Evaluator::Kernel Evaluator::best() {
+#ifdef EVALUATOR_X86
+  __builtin_cpu_init();
+  if (!__builtin_cpu_supports("popcnt")) return Kernel::Scalar;
+  if (__builtin_cpu_supports("avx2")) return Kernel::Avx2;
+  if (__builtin_cpu_supports("sse4.2")) return Kernel::Sse4;
+#endif
+  return Kernel::Scalar;
+}
+
+const char* Evaluator::name(Kernel kernel) {
+  switch (kernel) {
+    case Kernel::Avx2: return "avx2";
+    case Kernel::Sse4: return "sse4";
+    default: return "scalar";
+  }
+}
+
+BoardFeatures Evaluator::features(const Board& board) const {
+  return featuresFn(board);
+}
+
+float Evaluator::evaluate(const Board& board) const {
+  float score;
+  const Board* boards[] = { &board };
+  scoreFn(weights, boards, &score, 1);
+  return score;
+}
+
+void Evaluator::evaluate(const Board* const* boards, float* scores, int count) const {
+  scoreFn(weights, boards, scores, count);
+}
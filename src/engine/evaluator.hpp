@@ -0,0 +1,65 @@
+#pragma once
+
+#include "board.hpp"
+
+// weights for the board features positions are scored by. see: https://codemyroad.wordpress.com/2013/04/14/tetris-ai-the-near-perfect-player/
+// the transition and well features go beyond that player and are off unless given a weight.
+struct EvalWeights {
+  float height = -0.510066f;
+  float holes = -0.35663f;
+  float bumpiness = -0.184483f;
+  float rowTransitions = 0.0f;
+  float columnTransitions = 0.0f;
+  float wells = 0.0f;
+};
+
+struct BoardFeatures {
+  // sum of the column heights.
+  int height;
+  // empty tiles with a filled one somewhere above them.
+  int holes;
+  // sum of the height differences between neighbouring columns.
+  int bumpiness;
+  // filled and empty tiles side by side within a row, walls counting as filled. only rows under the stack count.
+  int rowTransitions;
+  // filled and empty tiles on top of each other within a column, the floor counting as filled, up to the stack top.
+  int columnTransitions;
+  // how far each column sits below the lower of its neighbours, walls counting as infinitely high.
+  int wells;
+};
+
+// scores boards by a weighted sum of their features, many at a time.
+// the kernel is picked once, at construction, from what the CPU supports. one board at a time, AVX2 counts bits over
+// eight rows per instruction, SSE4 uses the popcnt instruction a row at a time, and both compare all the column
+// heights as one vector. batches are scored across boards instead, a vector lane per board, eight at a time with
+// AVX2 and four with SSE4; boards left over are scored one at a time. the scalar kernel runs anywhere.
+// all of them work off the row words and column heights the board keeps, and give the same features and scores.
+class Evaluator {
+public:
+  enum Kernel { Scalar, Sse4, Avx2 };
+
+  // kernel is only a preference: one the CPU can't run falls back to the best one it can.
+  explicit Evaluator(const EvalWeights& weights = {}, Kernel kernel = Avx2);
+
+  // the fastest kernel this CPU can run.
+  static Kernel best();
+  static const char* name(Kernel kernel);
+
+  // the features of one board, with the kernel in use.
+  BoardFeatures features(const Board& board) const;
+
+  float evaluate(const Board& board) const;
+  // scores[i] = evaluate(*boards[i]), in one call. the vector kernels score several boards per step.
+  void evaluate(const Board* const* boards, float* scores, int count) const;
+
+  inline Kernel kernel() const { return active; }
+  inline const EvalWeights& getWeights() const { return weights; }
+private:
+  using FeaturesFn = BoardFeatures (*)(const Board& board);
+  using ScoreFn = void (*)(const EvalWeights& weights, const Board* const* boards, float* scores, int count);
+
+  EvalWeights weights;
+  Kernel active;
+  FeaturesFn featuresFn;
+  ScoreFn scoreFn;
+};
@@ -0,0 +1,285 @@
+#include "perfect_clear.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+
+namespace {
+  using Row = Board::Row;
+
+  constexpr Row EVEN_COLUMNS = [] {
+    Row mask = 0;
+    for (int x = 0; x < COLUMNS; x += 2) mask |= Board::bit(x);
+    return mask;
+  }();
+  constexpr Row ODD_COLUMNS = Board::FIELD & ~EVEN_COLUMNS;
+
+  // rows any rotation of any block reaches below its origin, so a block whose origin is this far above the stack
+  // turns freely without touching it.
+  constexpr int REACH_BELOW = [] {
+    int reach = 0;
+    for (const auto& rotations : Pieces::SHAPES)
+      for (const Pieces::Shape& shape : rotations)
+        for (const Pieces::Offset& offset : shape) reach = std::max(reach, -offset.y);
+    return reach;
+  }();
+
+  // how far a block can move column parity in either direction. whatever the rotation, I changes it by 0 or 4,
+  // T by 0 or 2, L and J by 2, and O, S and Z not at all.
+  constexpr int PARITY_REACH[Pieces::BLOCK_TYPES] = { 0, 4, 0, 2, 2, 2, 0, 0 };
+
+  inline int count(Row row) { return std::popcount(row); }
+}
+
+PerfectClear::PerfectClear(TaskPool& pool, PerfectClearSettings settings):
+  pool(pool),
+  settings(settings),
+  failed(TABLE_SIZE),
+  salt(0),
+  found(false),
+  stopped(false),
+  cancels(0),
+  searching(0)
+{
+  for (unsigned i = 0; i < pool.size(); i++)
+    workers.push_back(std::make_unique<Worker>());
+}
+
+int PerfectClear::blocksLeft(const Node& node) const {
+  return std::max((int)sequence.size() - node.next, 0) + (node.hold != BlockType::None);
+}
+
+bool PerfectClear::viable(const Node& node) const {
+  int empty = 0, parity = 0;
+
+  for (int y = 0; y < node.height; y++) {
+    Row filled = node.board.bits(y) & Board::FIELD;
+    empty += COLUMNS - count(filled);
+    parity += count(filled & EVEN_COLUMNS) - count(filled & ODD_COLUMNS);
+  }
+
+  // line clears take as many tiles as they leave room for, so the empty tiles only ever go down 4 at a time.
+  if (empty % 4 != 0 || empty / 4 > blocksLeft(node)) return false;
+
+  // a full row has five tiles in each, so parity has to come back to 0, and rows moving down doesn't change it.
+  int reach = node.hold != BlockType::None ? PARITY_REACH[node.hold] : 0;
+  for (int i = node.next; i < (int)sequence.size(); i++) reach += PARITY_REACH[sequence[i]];
+  if (parity % 2 != 0 || std::abs(parity) > reach) return false;
+
+  // columns filled to the top of the rows left stay that way as rows clear, and nothing fits across them.
+  Row walls = Board::FIELD;
+  for (int y = 0; y < node.height; y++) walls &= node.board.bits(y);
+  if (walls == 0) return true;
+
+  int side = 0;
+  for (int x = 0; x < COLUMNS; x++) {
+    if (walls & Board::bit(x)) {
+      if (side % 4 != 0) return false;
+      side = 0;
+      continue;
+    }
+
+    for (int y = 0; y < node.height; y++) side += !node.board.occupied(x, y);
+  }
+
+  return side % 4 == 0;
+}
+
+// empty tiles with no way up to the top row through other empty ones. reaching them takes a kick through the stack
+// or a line cleared above them first, which lets the rows over them fall in. searching for those costs far more than
+// they turn up, so positions with any are given up on.
+bool PerfectClear::unreachable(const Node& node) const {
+  const int height = node.height;
+  std::array<Row, ROWS + HIDDEN_ROWS> open, reached;
+
+  for (int y = 0; y < height; y++) {
+    open[y] = ~node.board.bits(y) & Board::FIELD;
+    reached[y] = 0;
+  }
+  reached[height - 1] = open[height - 1];
+
+  // spreads down, up and sideways until nothing more is reached.
+  for (bool changed = true; changed;) {
+    changed = false;
+
+    for (int y = height - 1; y >= 0; y--) {
+      Row row = reached[y];
+      if (y + 1 < height) row |= reached[y + 1] & open[y];
+      if (y > 0) row |= reached[y - 1] & open[y];
+
+      for (Row last = 0; row != last;) {
+        last = row;
+        row |= ((row << 1) | (row >> 1)) & open[y];
+      }
+
+      changed |= row != reached[y];
+      reached[y] = row;
+    }
+  }
+
+  for (int y = 0; y < height; y++)
+    if (open[y] & ~reached[y]) return true;
+
+  return false;
+}
+
+uint64_t PerfectClear::key(const Node& node) const {
+  return node.board.hash() ^ Zobrist::HOLD[node.hold]
+    ^ Zobrist::mix(salt ^ (uint64_t(node.next) << 48 | uint64_t(node.height) << 40));
+}
+
+bool PerfectClear::play(const Node& node, BlockType type, const Placement& placement, Node& child) const {
+  child.board = node.board;
+
+  for (const Coords& cell : Pieces::cells(Pieces::SHAPES[type][placement.rotation], placement.x, placement.y)) {
+    if (cell.y >= node.height) return false;
+    child.board.set(cell.x, cell.y, type);
+  }
+
+  child.height = node.height - child.board.clearLines();
+  return true;
+}
+
+void PerfectClear::generate(const Node& node, BlockType type, Placements& placements) const {
+  // everything above the rows left is empty, so a block high enough over them to turn without kicking can get
+  // anywhere the one at spawn can, through far fewer positions.
+  Coords spawn = Engine::spawnLocation(node.board, type);
+  placements.generate(node.board, type, spawn.x, node.height + REACH_BELOW, 0);
+}
+
+bool PerfectClear::search(const Node& node, int depth, Worker& worker) {
+  if (found || stopped) return false;
+
+  if (node.height == 0) {
+    if (!found.exchange(true)) solution.assign(worker.path.begin(), worker.path.begin() + depth);
+    return true;
+  }
+
+  if (depth >= (int)worker.plies.size()) return false;
+
+  if (cancels != searching || std::chrono::steady_clock::now() > deadline) {
+    stopped = true;
+    return false;
+  }
+
+  uint64_t position = key(node), data;
+  if (failed.probe(position, data)) return false;
+  if (!viable(node) || unreachable(node)) return false;
+
+  auto branch = [&](BlockType type, BlockType hold, int next, bool held) {
+    Placements& placements = worker.plies[depth];
+    generate(node, type, placements);
+    Node child;
+
+    for (const Placement& placement : placements.all()) {
+      if (!play(node, type, placement, child)) continue;
+
+      child.hold = hold;
+      child.next = next;
+      worker.path[depth] = { held, placement, {} };
+      if (search(child, depth + 1, worker)) return true;
+    }
+
+    return false;
+  };
+
+  if (node.next < (int)sequence.size()) {
+    BlockType current = sequence[node.next];
+
+    if (branch(current, node.hold, node.next + 1, false)) return true;
+
+    if (node.hold != BlockType::None && node.hold != current) {
+      if (branch(node.hold, current, node.next + 1, true)) return true;
+    } else if (node.hold == BlockType::None && node.next + 1 < (int)sequence.size()) {
+      if (branch(sequence[node.next + 1], current, node.next + 2, true)) return true;
+    }
+  } else if (node.hold != BlockType::None) {
+    // past the preview the held block can still be played, by holding whatever comes next.
+    if (branch(node.hold, BlockType::None, node.next + 1, true)) return true;
+  }
+
+  // a search cut short hasn't ruled the position out.
+  if (!found && !stopped) failed.store(position, 0);
+  return false;
+}
+
+bool PerfectClear::solve(const Engine& engine, std::vector<Step>& steps, uint32_t ticket) {
+  deadline = std::chrono::steady_clock::now() + settings.budget;
+  found = false;
+  // a cancel() that came in before this started still counts, since it moved cancels past ticket.
+  stopped = cancels != ticket;
+  searching = ticket;
+  salt += 0x9e3779b97f4a7c15ull;
+  steps.clear();
+  solution.clear();
+
+  const Block& block = engine.block();
+  const Board& board = engine.getBoard();
+  sequence.assign(1, block.type);
+  for (int i = 0; i < Rules::PREVIEW; i++)
+    sequence.push_back(engine.getNext(i));
+
+  int filled = 0;
+  for (int y = 0; y < board.stackHeight(); y++) filled += count(board.bits(y) & Board::FIELD);
+
+  for (int height = std::max(board.stackHeight(), 1); height <= settings.maxHeight && !found && !stopped; height++) {
+    Node root = { board, engine.getHold(), 0, height };
+    int empty = height * COLUMNS - filled;
+    if (empty % 4 != 0 || empty / 4 > blocksLeft(root)) continue;
+    if (!viable(root) || unreachable(root)) continue;
+
+    roots.clear();
+    auto branch = [&](BlockType type, BlockType hold, int next, bool held, bool fromBlock) {
+      if (fromBlock) rootPlacements.generate(board, type, block.x, block.y, block.rotation);
+      else generate(root, type, rootPlacements);
+
+      Move move;
+      for (const Placement& placement : rootPlacements.all()) {
+        if (!play(root, type, placement, move.child)) continue;
+
+        move.child.hold = hold;
+        move.child.next = next;
+        move.step = { held, placement, {} };
+        roots.push_back(move);
+      }
+    };
+
+    // the first block is searched from where it is now, so the line found still holds after gravity moved it.
+    branch(block.type, root.hold, 1, false, true);
+
+    if (!engine.isHoldLocked()) {
+      if (root.hold != BlockType::None && root.hold != block.type) branch(root.hold, block.type, 1, true, false);
+      else if (root.hold == BlockType::None) branch(sequence[1], block.type, 2, true, false);
+    }
+
+    pool.parallelFor(roots.size(), [&](int i) {
+      Worker& worker = *workers[TaskPool::worker()];
+      worker.path[0] = roots[i].step;
+      search(roots[i].child, 1, worker);
+    });
+  }
+
+  if (!found) return false;
+
+  // rows cleared along the way are gone from the board the later steps land on, so their tiles are put back in the
+  // rows they take up now.
+  Board played = board;
+  std::vector<int> rows(Board::HEIGHT);
+  for (int y = 0; y < Board::HEIGHT; y++) rows[y] = y;
+
+  for (Step& step : solution) {
+    const Placement& placement = step.placement;
+    std::array<Coords, 4> cells = Pieces::cells(Pieces::SHAPES[placement.type][placement.rotation], placement.x, placement.y);
+
+    for (int i = 0; i < 4; i++) {
+      played.set(cells[i].x, cells[i].y, placement.type);
+      step.cells[i] = { cells[i].x, rows[cells[i].y] };
+    }
+
+    for (int y = ROWS + HIDDEN_ROWS - 1; y >= 0; y--)
+      if (played.rowFull(y)) rows.erase(rows.begin() + y);
+    played.clearLines();
+  }
+
+  steps = solution;
+  return true;
+}
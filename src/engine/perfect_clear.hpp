@@ -0,0 +1,107 @@
+#pragma once
+
+#include "engine.hpp"
+#include "placements.hpp"
+#include "task_pool.hpp"
+#include "transposition.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+struct PerfectClearSettings {
+  // tallest stack a clear is looked for in. every extra row needs two and a half more blocks than the preview has.
+  int maxHeight = 4;
+  // how long solve() may search before giving up.
+  std::chrono::microseconds budget = std::chrono::milliseconds(300);
+};
+
+// depth-first search for placements of the active block, hold and the preview that leave the board empty.
+// a clear of height h fills every empty tile in the bottom h rows and nothing above them, so a board is only
+// searched at heights where the empty tiles come to a multiple of 4 the known blocks can cover, and positions that
+// can't come to that are cut off before their placements are generated:
+// - too many empty tiles for the blocks left.
+// - column parity (filled tiles in even columns minus odd ones) out of reach of the blocks left. a full row has five
+//   of each, so clearing it leaves the count alone, and each shape can only move it by a known amount.
+// - a column filled all the way up splits the rows into two sides no block can span, so each side's empty tiles
+//   must come to a multiple of 4 on their own.
+// - empty tiles cut off from the open rows. these need a line cleared over them first, which this search treats as
+//   not worth following (see unreachable()).
+// positions that failed are remembered in a transposition table, and the root's moves are shared out across the pool.
+class PerfectClear {
+public:
+  struct Step {
+    // the block is held first, so the one played is the held one or, with hold empty, the next.
+    bool hold;
+    Placement placement;
+    // the tiles it fills, in the rows of the board the search started from, so the whole line can be drawn at once.
+    std::array<Coords, 4> cells;
+  };
+
+  explicit PerfectClear(TaskPool& pool, PerfectClearSettings settings = {});
+
+  // fills steps with placements that clear the board, in order, and returns whether it found any in time.
+  // the first one is searched from where the active block is now. it gives up early once cancel() is called after
+  // ticket was taken.
+  bool solve(const Engine& engine, std::vector<Step>& steps, uint32_t ticket);
+  inline bool solve(const Engine& engine, std::vector<Step>& steps) { return solve(engine, steps, this->ticket()); }
+  // take it with the position to search, so a cancel() between the two still calls that search off.
+  inline uint32_t ticket() const { return cancels; }
+  // makes a solve() running on another thread give up as soon as it can.
+  inline void cancel() { cancels++; }
+private:
+  struct Node {
+    Board board;
+    BlockType hold;
+    // index of the next block to play in the known sequence.
+    int next;
+    // rows left to clear.
+    int height;
+  };
+
+  // what each worker thread searches with: a placement search per ply, and the steps leading to where it is.
+  struct Worker {
+    std::array<Placements, Rules::PREVIEW + 2> plies;
+    std::array<Step, Rules::PREVIEW + 2> path;
+  };
+
+  struct Move {
+    Node child;
+    Step step;
+  };
+
+  bool search(const Node& node, int depth, Worker& worker);
+  bool play(const Node& node, BlockType type, const Placement& placement, Node& child) const;
+  // placements of type from above the rows left, which reach everything the spawn position does.
+  void generate(const Node& node, BlockType type, Placements& placements) const;
+
+  // blocks still to come, counting the held one.
+  int blocksLeft(const Node& node) const;
+  bool viable(const Node& node) const;
+  bool unreachable(const Node& node) const;
+  uint64_t key(const Node& node) const;
+
+  TaskPool& pool;
+  PerfectClearSettings settings;
+
+  std::vector<BlockType> sequence;
+  std::vector<Move> roots;
+  Placements rootPlacements;
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::vector<Step> solution;
+
+  static constexpr size_t TABLE_SIZE = 1 << 16;
+  // positions searched to the end without a clear.
+  TranspositionTable failed;
+  // changes every solve, so failures against another queue don't count.
+  uint64_t salt;
+
+  std::chrono::steady_clock::time_point deadline;
+  std::atomic<bool> found;
+  // out of time or called off.
+  std::atomic<bool> stopped;
+  std::atomic<uint32_t> cancels;
+  // the ticket the running solve() was given.
+  uint32_t searching;
+};
@@ -0,0 +1,122 @@
+// see: https://tetris.wiki/Super_Rotation_System
+
+#pragma once
+#include "block.hpp"
+#include "board.hpp"
+#include <array>
+
+// every shape, rotation state and kick offset, built at compile time and indexed by BlockType.
+// offsets are in tiles with y pointing up, relative to the tile the block rotates around (its origin).
+namespace Pieces {
+  struct Offset {
+    int x, y;
+  };
+
+  using Shape = std::array<Offset, 4>;
+  using Kicks = std::array<Offset, 5>;
+
+  constexpr int BLOCK_TYPES = 8;
+  constexpr int ROTATIONS = 4;
+
+  // spawn state of every block. the last value is the origin.
+  inline constexpr std::array<Shape, BLOCK_TYPES> SPAWN_SHAPES = {{
+    {},
+    { { { -1, 0 }, { 1, 0 }, { 2, 0 }, { 0, 0 } } },
+    { { { 0, 1 }, { 1, 1 }, { 1, 0 }, { 0, 0 } } },
+    { { { -1, 0 }, { 1, 0 }, { 0, 1 }, { 0, 0 } } },
+    { { { -1, 0 }, { 1, 0 }, { 1, 1 }, { 0, 0 } } },
+    { { { -1, 1 }, { -1, 0 }, { 1, 0 }, { 0, 0 } } },
+    { { { -1, 1 }, { 0, 1 }, { 1, 0 }, { 0, 0 } } },
+    { { { 1, 1 }, { 0, 1 }, { -1, 0 }, { 0, 0 } } },
+  }};
+
+  // true center of rotation relative to the origin, doubled so I and O can sit between tiles.
+  inline constexpr std::array<Offset, BLOCK_TYPES> CENTERS = {{
+    { 0, 0 }, { 1, -1 }, { 1, 1 }, { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 }
+  }};
+
+  // column of the origin at spawn, relative to the middle-left column.
+  inline constexpr std::array<int, BLOCK_TYPES> SPAWN_COLUMNS = { 0, 0, 0, 0, 1, 1, 1, 1 };
+
+  // indexed by board cell: empty, each BlockType, then garbage.
+  inline constexpr std::array<Color, BLOCK_TYPES + 1> COLORS = {
+    Colors::empty, Colors::lightBlue, Colors::yellow, Colors::violet,
+    Colors::orange, Colors::red, Colors::green, Colors::darkBlue, Colors::garbage
+  };
+
+  // clockwise kicks for 0->1, 1->2, 2->3 and 3->0. counterclockwise kicks are the same tests negated.
+  inline constexpr std::array<Kicks, ROTATIONS> CLOCKWISE_KICKS = {{
+    { { { 0, 0 }, { -1, 0 }, { -1, 1 }, { 0, -2 }, { -1, -2 } } },
+    { { { 0, 0 }, { 1, 0 }, { 1, -1 }, { 0, 2 }, { 1, 2 } } },
+    { { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, -2 }, { 1, -2 } } },
+    { { { 0, 0 }, { -1, 0 }, { -1, -1 }, { 0, 2 }, { -1, 2 } } },
+  }};
+
+  inline constexpr std::array<Kicks, ROTATIONS> CLOCKWISE_KICKS_I = {{
+    { { { 0, 0 }, { -2, 0 }, { 1, 0 }, { -2, -1 }, { 1, 2 } } },
+    { { { 0, 0 }, { -1, 0 }, { 2, 0 }, { -1, 2 }, { 2, -1 } } },
+    { { { 0, 0 }, { 2, 0 }, { -1, 0 }, { 2, 1 }, { -1, -2 } } },
+    { { { 0, 0 }, { 1, 0 }, { -2, 0 }, { 1, -2 }, { -2, 1 } } },
+  }};
+
+  // SHAPES[type][rotation]
+  inline constexpr auto SHAPES = [] {
+    std::array<std::array<Shape, ROTATIONS>, BLOCK_TYPES> shapes = {};
+
+    for (int type = 0; type < BLOCK_TYPES; type++) {
+      const Offset center = CENTERS[type];
+      shapes[type][0] = SPAWN_SHAPES[type];
+
+      for (int rotation = 1; rotation < ROTATIONS; rotation++) {
+        for (int i = 0; i < 4; i++) {
+          const Offset previous = shapes[type][rotation - 1][i];
+          const Offset doubled = { previous.x * 2 - center.x, previous.y * 2 - center.y };
+
+          // a clockwise quarter turn, (x, y) -> (y, -x), then back to whole tiles.
+          shapes[type][rotation][i] = { (doubled.y + center.x) / 2, (-doubled.x + center.y) / 2 };
+        }
+      }
+    }
+
+    return shapes;
+  }();
+
+  // KICKS[type][from][to]. pairs that aren't a quarter turn apart, and every pair for O, only test in place.
+  inline constexpr auto KICKS = [] {
+    std::array<std::array<std::array<Kicks, ROTATIONS>, ROTATIONS>, BLOCK_TYPES> kicks = {};
+
+    for (int type = 0; type < BLOCK_TYPES; type++) {
+      if (type == BlockType::O || type == BlockType::None) continue;
+      const auto& clockwise = type == BlockType::I ? CLOCKWISE_KICKS_I : CLOCKWISE_KICKS;
+
+      for (int from = 0; from < ROTATIONS; from++) {
+        int to = (from + 1) % ROTATIONS;
+
+        for (int i = 0; i < 5; i++) {
+          kicks[type][from][to][i] = clockwise[from][i];
+          kicks[type][to][from][i] = { -clockwise[from][i].x, -clockwise[from][i].y };
+        }
+      }
+    }
+
+    return kicks;
+  }();
+
+  // absolute tiles covered by a shape whose origin sits at (x, y).
+  inline constexpr std::array<Coords, 4> cells(const Shape& shape, int x, int y) {
+    return {{
+      { x + shape[0].x, y + shape[0].y },
+      { x + shape[1].x, y + shape[1].y },
+      { x + shape[2].x, y + shape[2].y },
+      { x + shape[3].x, y + shape[3].y },
+    }};
+  }
+
+  inline constexpr std::array<Coords, 4> cells(const Block& block, int dx = 0, int dy = 0) {
+    return cells(SHAPES[block.type][block.rotation], block.x + dx, block.y + dy);
+  }
+
+  static_assert(Board::GARBAGE == BLOCK_TYPES, "garbage is the cell after the last block type");
+  static_assert(SHAPES[BlockType::T][1][2].x == 1 && SHAPES[BlockType::T][1][2].y == 0, "T points right after one clockwise turn");
+  static_assert(SHAPES[BlockType::I][2][3].x == 1 && SHAPES[BlockType::I][2][3].y == -1, "I rotates around the center of its box");
+}
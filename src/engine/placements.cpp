@@ -0,0 +1,175 @@
+#include "placements.hpp"
+#include <algorithm>
+
+namespace {
+  // lowest rotation with the same footprint, and the corner of that footprint relative to the origin.
+  // I, S and Z look the same after half a turn, and O after any turn, so those land on the same cells.
+  struct Footprint {
+    int rotation;
+    int x, y;
+  };
+
+  static_assert([] {
+    for (const auto& rotations : Pieces::SHAPES)
+      for (const Pieces::Shape& shape : rotations)
+        for (const Pieces::Offset& offset : shape)
+          if (offset.x < -Placements::REACH || offset.x > Placements::REACH || offset.y < -Placements::REACH
+            || offset.y > Placements::REACH) return false;
+    return true;
+  }(), "a tile sits further from its origin than Placements::REACH");
+
+  constexpr auto FOOTPRINTS = [] {
+    std::array<std::array<Footprint, Pieces::ROTATIONS>, Pieces::BLOCK_TYPES> footprints = {};
+    std::array<std::array<std::array<int, 4>, Pieces::ROTATIONS>, Pieces::BLOCK_TYPES> normalized = {};
+
+    for (int type = 0; type < Pieces::BLOCK_TYPES; type++) {
+      for (int rotation = 0; rotation < Pieces::ROTATIONS; rotation++) {
+        const Pieces::Shape& shape = Pieces::SHAPES[type][rotation];
+        int minX = shape[0].x, minY = shape[0].y;
+
+        for (const Pieces::Offset& offset : shape) {
+          minX = std::min(minX, offset.x);
+          minY = std::min(minY, offset.y);
+        }
+
+        for (int i = 0; i < 4; i++)
+          normalized[type][rotation][i] = (shape[i].y - minY) * 4 + (shape[i].x - minX);
+        std::sort(normalized[type][rotation].begin(), normalized[type][rotation].end());
+
+        int same = rotation;
+        for (int earlier = 0; earlier < rotation; earlier++) {
+          if (normalized[type][earlier] == normalized[type][rotation]) {
+            same = earlier;
+            break;
+          }
+        }
+
+        footprints[type][rotation] = { same, minX, minY };
+      }
+    }
+
+    return footprints;
+  }();
+}
+
+Placements::Placements(): board(nullptr), type(BlockType::None), search(0) {
+  visited.fill(0);
+  dropped.fill(0);
+  found.fill(0);
+  placements.reserve(STATES);
+}
+
+void Placements::generate(const Board& board, BlockType type) {
+  Coords spawn = Engine::spawnLocation(board, type);
+  generate(board, type, spawn.x, spawn.y, 0);
+}
+
+void Placements::generate(const Board& board, BlockType type, int x, int y, int rotation) {
+  this->board = &board;
+  this->type = type;
+  placements.clear();
+
+  if (++search == 0) {
+    visited.fill(0);
+    dropped.fill(0);
+    found.fill(0);
+    search = 1;
+  }
+
+  if (type == BlockType::None || !inBounds(x, y) || !fits(x, y, rotation)) return;
+
+  int start = index(x, y, rotation);
+  visited[start] = search;
+  distance[start] = 0;
+  parent[start] = start;
+
+  head = 0;
+  tail = 0;
+  queue[tail++] = start;
+
+  while (head < tail) {
+    int state = queue[head++];
+    int r = state / (WIDTH * HEIGHT);
+    int sy = state / WIDTH % HEIGHT + MIN_Y;
+    int sx = state % WIDTH + MIN_X;
+
+    int landY = landing(sx, sy, r);
+    const Footprint& footprint = FOOTPRINTS[type][r];
+    int key = (footprint.rotation * HEIGHT + (landY + footprint.y)) * COLUMNS + (sx + footprint.x);
+
+    if (found[key] != search) {
+      found[key] = search;
+      placements.push_back({ type, r, sx, landY, distance[state] + 1, state });
+    }
+
+    visit(sx - 1, sy, r, state, Input::MoveLeft);
+    visit(sx + 1, sy, r, state, Input::MoveRight);
+    visit(sx, sy - 1, r, state, Input::SoftDrop);
+
+    if (type != BlockType::O) {
+      for (int direction : { 1, -1 }) {
+        int to = (r + direction + Pieces::ROTATIONS) % Pieces::ROTATIONS;
+
+        // the first kick that fits is the one the engine takes, so this stops at the same one.
+        for (const Pieces::Offset& kick : Pieces::KICKS[type][r][to]) {
+          int kx = sx + kick.x, ky = sy + kick.y;
+
+          // left, right or below the search space every tile is in a wall or the floor, which the engine rejects
+          // too. above it they clamp into the open sky, so the engine would take the kick; it can't be followed
+          // from here, but no later kick is tried either.
+          if (!inBounds(kx, ky)) {
+            if (kx >= MIN_X && kx < MIN_X + WIDTH && ky >= MIN_Y + HEIGHT) break;
+            continue;
+          }
+
+          if (!fits(kx, ky, to)) continue;
+
+          visit(kx, ky, to, state, direction == 1 ? Input::RotateClockwise : Input::RotateCounterclockwise);
+          break;
+        }
+      }
+    }
+  }
+}
+
+void Placements::visit(int x, int y, int rotation, int from, Input input) {
+  if (!inBounds(x, y)) return;
+
+  int state = index(x, y, rotation);
+  if (visited[state] == search) return;
+
+  // rotations were already tested against their kicks, so only translations still need a fit check.
+  if (input != Input::RotateClockwise && input != Input::RotateCounterclockwise && !fits(x, y, rotation)) return;
+
+  visited[state] = search;
+  parent[state] = from;
+  distance[state] = distance[from] + 1;
+  via[state] = input;
+  queue[tail++] = state;
+}
+
+int Placements::landing(int x, int y, int rotation) {
+  int bottom = y;
+
+  while (dropped[index(x, bottom, rotation)] != search && bottom > MIN_Y && fits(x, bottom - 1, rotation))
+    bottom--;
+
+  int landY = dropped[index(x, bottom, rotation)] == search ? drop[index(x, bottom, rotation)] : bottom;
+
+  for (int row = y; row >= bottom; row--) {
+    dropped[index(x, row, rotation)] = search;
+    drop[index(x, row, rotation)] = landY;
+  }
+
+  return landY;
+}
+
+void Placements::path(const Placement& placement, std::vector<Input>& inputs) const {
+  inputs.clear();
+
+  for (int state = placement.from; parent[state] != state; state = parent[state])
+    inputs.push_back(static_cast<Input>(via[state]));
+
+  std::reverse(inputs.begin(), inputs.end());
+  inputs.push_back(Input::HardDrop);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "board.hpp"
+#include "engine.hpp"
+#include "pieces.hpp"
+#include <vector>
+
+// a spot a block can be hard dropped into. positions are in tiles, like Board.
+struct Placement {
+  BlockType type;
+  int rotation;
+  // where the origin comes to rest.
+  int x, y;
+  // length of the shortest input sequence reaching it, including the hard drop.
+  int inputs;
+  // search node the hard drop is made from, used to rebuild that sequence.
+  int from;
+};
+
+// breadth-first search over (x, y, rotation) for everything a block can be moved, soft dropped,
+// rotated or kicked into. every distinct set of landing cells is reported once, with its shortest path.
+// instances keep their scratch buffers between searches, so reuse one rather than making one per call.
+class Placements {
+public:
+  // every origin a block can fit at: tiles are at most REACH from the origin, so one further out than that from the
+  // field has all of them in a wall or the floor. above, the board's own rows end the search.
+  static constexpr int REACH = 2;
+  static constexpr int MIN_X = -REACH;
+  static constexpr int WIDTH = COLUMNS + 2 * REACH;
+  static constexpr int MIN_Y = -REACH;
+  static constexpr int HEIGHT = Board::HEIGHT - Board::FLOOR - MIN_Y;
+  static constexpr int STATES = WIDTH * HEIGHT * Pieces::ROTATIONS;
+  static_assert(STATES <= 0x10000, "search nodes are indexed with 16 bits");
+
+  Placements();
+
+  // starts from where the engine would spawn the block.
+  void generate(const Board& board, BlockType type);
+  // starts from an arbitrary origin and rotation, e.g. a block already in play.
+  void generate(const Board& board, BlockType type, int x, int y, int rotation);
+
+  inline const std::vector<Placement>& all() const { return placements; }
+
+  // fills inputs with the moves that take a freshly placed block to the placement, ending in a hard drop.
+  void path(const Placement& placement, std::vector<Input>& inputs) const;
+private:
+  static inline int index(int x, int y, int rotation) {
+    return ((rotation * HEIGHT) + (y - MIN_Y)) * WIDTH + (x - MIN_X);
+  }
+
+  static inline bool inBounds(int x, int y) {
+    return x >= MIN_X && x < MIN_X + WIDTH && y >= MIN_Y && y < MIN_Y + HEIGHT;
+  }
+
+  inline bool fits(int x, int y, int rotation) const {
+    return board->fits(Pieces::cells(Pieces::SHAPES[type][rotation], x, y));
+  }
+
+  void visit(int x, int y, int rotation, int parent, Input input);
+  int landing(int x, int y, int rotation);
+
+  const Board* board;
+  BlockType type;
+
+  // entries are only valid when their stamp matches the current search.
+  uint32_t search;
+  std::array<uint32_t, STATES> visited;
+  std::array<uint32_t, STATES> dropped;
+  std::array<uint32_t, Pieces::ROTATIONS * COLUMNS * HEIGHT> found;
+
+  std::array<int8_t, STATES> drop;
+  std::array<uint16_t, STATES> parent;
+  std::array<uint16_t, STATES> distance;
+  std::array<uint8_t, STATES> via;
+
+  std::array<uint16_t, STATES> queue;
+  int head, tail;
+  std::vector<Placement> placements;
+};
@@ -0,0 +1,90 @@
+#include "randomizer.hpp"
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+void Xoshiro256::seed(uint64_t value) {
+  // splitmix64 spreads any seed, including 0, over the whole state.
+  for (uint64_t& word : state) {
+    uint64_t z = (value += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    word = z ^ (z >> 31);
+  }
+}
+
+PieceGenerator::PieceGenerator(Randomizer mode, uint64_t seed): mode(mode), random(seed) {
+  reset();
+}
+
+void PieceGenerator::seed(uint64_t value) {
+  random.seed(value);
+  reset();
+}
+
+void PieceGenerator::reset() {
+  bagIndex = bag.size();
+  history = { BlockType::Z, BlockType::Z, BlockType::S, BlockType::S };
+  first = true;
+}
+
+BlockType PieceGenerator::next() {
+  BlockType block = BlockType::None;
+
+  switch (mode) {
+    case Randomizer::Bag:
+      if (bagIndex == (int)bag.size()) {
+        bag = { BlockType::I, BlockType::O, BlockType::T, BlockType::L, BlockType::J, BlockType::S, BlockType::Z };
+
+        for (int i = bag.size() - 1; i > 0; i--)
+          std::swap(bag[i], bag[random.below(i + 1)]);
+
+        bagIndex = 0;
+      }
+
+      block = bag[bagIndex++];
+      break;
+    case Randomizer::History:
+      for (int roll = 0; roll < 6; roll++) {
+        block = static_cast<BlockType>(random.below(7) + 1);
+        if (std::find(history.begin(), history.end(), block) == history.end()) break;
+      }
+
+      // the opening block is never one that can only be placed with an overhang.
+      while (first && (block == BlockType::S || block == BlockType::Z || block == BlockType::O))
+        block = static_cast<BlockType>(random.below(7) + 1);
+
+      std::rotate(history.begin(), history.begin() + 1, history.end());
+      history.back() = block;
+      break;
+    case Randomizer::Classic:
+      block = static_cast<BlockType>(random.below(7) + 1);
+      if (!first && block == history.back()) block = static_cast<BlockType>(random.below(7) + 1);
+
+      history.back() = block;
+      break;
+  }
+
+  first = false;
+  return block;
+}
+
+// a bool copied in as raw bytes can hold any value, and loading one that isn't 0 or 1 is undefined, so its byte is
+// looked at instead.
+static inline bool isBool(const bool& value) {
+  uint8_t byte;
+  memcpy(&byte, &value, 1);
+  return byte <= 1;
+}
+
+bool PieceGenerator::valid() const {
+  // the mode is read the same way as the flag, since a value outside the enum is no safer to load.
+  std::underlying_type_t<Randomizer> raw;
+  memcpy(&raw, &mode, sizeof(raw));
+
+  // the bag is only filled once the first block is dealt from it, so just what is still to come is checked.
+  return isBool(first) && raw >= Randomizer::Bag && raw <= Randomizer::Classic
+    && bagIndex >= 0 && bagIndex <= (int)bag.size()
+    && std::all_of(bag.begin() + bagIndex, bag.end(),
+      [](BlockType block) { return block >= BlockType::I && block <= BlockType::Z; });
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "block.hpp"
+#include <array>
+#include <cstdint>
+
+// xoshiro256**. small, fast and good enough for anything a game needs.
+// see: https://prng.di.unimi.it/
+class Xoshiro256 {
+public:
+  explicit Xoshiro256(uint64_t seed = 0) { this->seed(seed); }
+
+  void seed(uint64_t value);
+
+  inline uint64_t operator()() {
+    const uint64_t result = rotl(state[1] * 5, 7) * 9;
+    const uint64_t t = state[1] << 17;
+
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 45);
+
+    return result;
+  }
+
+  // uniform in [0, bound), without the bias of a plain modulo.
+  // Lemire's method: the high half of a 32-bit draw times bound, redrawn in the rare case the low half lands in the
+  // 2^32 % bound values that would make some results one draw more likely than others.
+  // see: https://arxiv.org/abs/1805.10941
+  inline uint32_t below(uint32_t bound) {
+    uint64_t product = ((*this)() >> 32) * bound;
+
+    if (uint32_t(product) < bound) {
+      const uint32_t threshold = -bound % bound;
+      while (uint32_t(product) < threshold) product = ((*this)() >> 32) * bound;
+    }
+
+    return uint32_t(product >> 32);
+  }
+private:
+  static inline uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+  std::array<uint64_t, 4> state;
+};
+
+enum Randomizer {
+  // every block once per shuffled bag of seven.
+  Bag,
+  // rerolls up to six times while the roll is among the last four blocks dealt.
+  History,
+  // rerolls once if the roll matches the last block.
+  Classic
+};
+
+// deals the block sequence of one game. holds no pointers, so copying it copies the sequence exactly.
+class PieceGenerator {
+public:
+  explicit PieceGenerator(Randomizer mode = Randomizer::Bag, uint64_t seed = 0);
+
+  void seed(uint64_t value);
+  // forgets what has been dealt (bag contents, history) without touching the random state.
+  void reset();
+
+  BlockType next();
+
+  inline Randomizer getMode() const { return mode; }
+  inline void setMode(Randomizer value) { mode = value; reset(); }
+
+  // whether the mode is one of the above, every block left in the bag is a real one and the flag holds 0 or 1,
+  // for checking a generator read back from a file.
+  bool valid() const;
+private:
+  Randomizer mode;
+  Xoshiro256 random;
+
+  std::array<BlockType, 7> bag;
+  int bagIndex;
+
+  std::array<BlockType, 4> history;
+  bool first;
+};
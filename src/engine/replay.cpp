@@ -0,0 +1,270 @@
+#include "replay.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+
+// keyframes are the engine's raw bytes.
+static_assert(std::is_trivially_copyable_v<Engine>, "Engine must stay trivially copyable to be saved in keyframes");
+
+using namespace Replays;
+
+// reads the event at offset and moves past it, adding its tick delta to tick.
+static Input decode(const uint8_t* events, uint64_t size, uint64_t& offset, uint64_t& tick) {
+  uint8_t byte = events[offset++];
+  uint64_t delta = byte >> 3;
+
+  if (delta == 31) {
+    uint64_t extra = 0;
+    // a corrupt file can run a varint on for longer than a delta has bits.
+    for (int shift = 0; offset < size && shift < 64; shift += 7) {
+      uint8_t part = events[offset++];
+      extra |= uint64_t(part & 0x7f) << shift;
+      if (!(part & 0x80)) break;
+    }
+
+    delta += extra;
+  }
+
+  tick += delta;
+  return static_cast<Input>(byte & 7);
+}
+
+// whether length bytes from offset fit in size, without the sum overflowing.
+static inline bool within(uint64_t offset, uint64_t length, uint64_t size) {
+  return offset <= size && length <= size - offset;
+}
+
+void ReplayRecorder::begin(const Engine& engine, uint64_t seed, Randomizer randomizer) {
+  this->seed = seed;
+  this->randomizer = randomizer;
+  lastTick = engine.getTicks();
+  events = 0;
+  tickRate = engine.getTickRate();
+
+  stream.clear();
+  keyframes.clear();
+  states.clear();
+  stream.reserve(RESERVED_SECONDS * EVENTS_PER_SECOND);
+  keyframes.reserve(RESERVED_SECONDS / KEYFRAME_INTERVAL + 1);
+  states.reserve(RESERVED_SECONDS / KEYFRAME_INTERVAL + 1);
+
+  keyframes.push_back({ engine.getTicks(), 0, lastTick, 0 });
+  states.push_back(engine);
+}
+
+void ReplayRecorder::input(const Engine& engine, Input input) {
+  if (!recording()) return;
+
+  uint64_t delta = engine.getTicks() - lastTick;
+  lastTick = engine.getTicks();
+  events++;
+
+  if (delta < 31) {
+    stream.push_back(uint8_t(delta << 3 | input));
+    return;
+  }
+
+  stream.push_back(uint8_t(31 << 3 | input));
+  for (delta -= 31; delta >= 0x80; delta >>= 7)
+    stream.push_back(uint8_t(delta | 0x80));
+  stream.push_back(uint8_t(delta));
+}
+
+void ReplayRecorder::tick(const Engine& engine) {
+  if (!recording() || engine.getTicks() % (KEYFRAME_INTERVAL * tickRate) != 0) return;
+
+  keyframes.push_back({ engine.getTicks(), stream.size(), lastTick, 0 });
+  states.push_back(engine);
+}
+
+void ReplayRecorder::rewind(const Engine& engine) {
+  if (!recording()) return;
+
+  uint64_t tick = engine.getTicks();
+  while (keyframes.size() > 1 && keyframes.back().tick >= tick) {
+    keyframes.pop_back();
+    states.pop_back();
+  }
+
+  // walk the events from the last keyframe kept up to the first one at or after tick, and cut the stream there.
+  const Keyframe& from = keyframes.back();
+  uint64_t offset = from.eventOffset, eventTick = from.eventTick;
+
+  while (offset < stream.size()) {
+    uint64_t next = offset, nextTick = eventTick;
+    decode(stream.data(), stream.size(), next, nextTick);
+    if (nextTick >= tick) break;
+
+    offset = next;
+    eventTick = nextTick;
+  }
+
+  for (uint64_t at = offset, ignored = 0; at < stream.size(); events--)
+    decode(stream.data(), stream.size(), at, ignored);
+
+  stream.resize(offset);
+  lastTick = eventTick;
+
+  if (keyframes.back().tick < tick) {
+    keyframes.push_back({ tick, stream.size(), lastTick, 0 });
+    states.push_back(engine);
+  } else states.back() = engine;
+}
+
+bool ReplayRecorder::save(const char* path, const Engine& engine) const {
+  static constexpr uint8_t PADDING[alignof(Keyframe)] = {};
+  if (!recording()) return false;
+
+  FILE* file = fopen(path, "wb");
+  if (!file) return false;
+
+  Header header = {};
+  memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.stateSize = sizeof(Engine);
+  header.randomizer = randomizer;
+  header.tickRate = tickRate;
+  header.seed = seed;
+  header.length = engine.getTicks();
+  header.events = events;
+  header.score = engine.getScore();
+  header.eventsOffset = sizeof(Header);
+  header.eventsSize = stream.size();
+
+  // states are laid out after the events, then the index pointing into them. readers use the index in place, so it
+  // is padded out to where a Keyframe can start.
+  uint64_t stateOffset = header.eventsOffset + header.eventsSize;
+  uint64_t statesEnd = stateOffset + states.size() * sizeof(Engine);
+  header.indexOffset = (statesEnd + alignof(Keyframe) - 1) / alignof(Keyframe) * alignof(Keyframe);
+  header.keyframes = keyframes.size();
+
+  std::vector<Keyframe> index = keyframes;
+  for (size_t i = 0; i < index.size(); i++)
+    index[i].stateOffset = stateOffset + i * sizeof(Engine);
+
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+    && fwrite(stream.data(), 1, stream.size(), file) == stream.size()
+    && fwrite(states.data(), sizeof(Engine), states.size(), file) == states.size()
+    && fwrite(PADDING, 1, header.indexOffset - statesEnd, file) == header.indexOffset - statesEnd
+    && fwrite(index.data(), sizeof(Keyframe), index.size(), file) == index.size();
+
+  return fclose(file) == 0 && ok;
+}
+
+Replay::Replay(): data(nullptr), size(0) {}
+
+Replay::~Replay() { close(); }
+
+bool Replay::open(const char* path) {
+  close();
+
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(Header)) {
+    ::close(fd);
+    return false;
+  }
+
+  void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED) return false;
+
+  data = static_cast<const uint8_t*>(mapped);
+  size = info.st_size;
+
+  const Header& header = this->header();
+  bool valid = memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0
+    && header.version == VERSION
+    && header.stateSize == sizeof(Engine)
+    && header.keyframes > 0
+    && within(header.eventsOffset, header.eventsSize, size)
+    && header.indexOffset % alignof(Keyframe) == 0
+    && header.indexOffset <= size && header.keyframes <= (size - header.indexOffset) / sizeof(Keyframe);
+
+  // seek() copies engines straight out of the mapping and decodes events from where the keyframes say, so a truncated
+  // or corrupt file is turned away here instead of being read past. the engines themselves are checked too, since
+  // a block type or preview entry out of range would index the piece tables out of bounds on the first step or draw.
+  if (valid) {
+    const Keyframe* index = reinterpret_cast<const Keyframe*>(data + header.indexOffset);
+    Engine engine;
+
+    for (uint64_t i = 0; valid && i < header.keyframes; i++) {
+      valid = within(index[i].stateOffset, sizeof(Engine), size) && index[i].eventOffset <= header.eventsSize;
+      if (!valid) break;
+
+      memcpy(static_cast<void*>(&engine), data + index[i].stateOffset, sizeof(Engine));
+      valid = engine.valid();
+    }
+  }
+
+  if (!valid) close();
+  return valid;
+}
+
+void Replay::close() {
+  if (data) munmap(const_cast<uint8_t*>(data), size);
+  data = nullptr;
+  size = 0;
+}
+
+void Replay::readEvent(Cursor& cursor) const {
+  const Header& header = this->header();
+
+  if (cursor.offset >= header.eventsSize) {
+    cursor.nextTick = ~0ull;
+    return;
+  }
+
+  cursor.nextInput = decode(data + header.eventsOffset, header.eventsSize, cursor.offset, cursor.eventTick);
+  cursor.nextTick = cursor.eventTick;
+}
+
+void Replay::seek(Engine& engine, Cursor& cursor, uint64_t tick) const {
+  const Header& header = this->header();
+  const Keyframe* index = reinterpret_cast<const Keyframe*>(data + header.indexOffset);
+
+  const Keyframe* keyframe = std::upper_bound(index, index + header.keyframes, tick,
+    [](uint64_t tick, const Keyframe& keyframe) { return tick < keyframe.tick; });
+  if (keyframe != index) keyframe--;
+
+  memcpy(static_cast<void*>(&engine), data + keyframe->stateOffset, sizeof(Engine));
+
+  cursor.offset = keyframe->eventOffset;
+  cursor.eventTick = keyframe->eventTick;
+  readEvent(cursor);
+
+  while (engine.getTicks() < tick && step(engine, cursor));
+}
+
+uint64_t Replay::keyframeTick(uint64_t i) const {
+  return reinterpret_cast<const Keyframe*>(data + header().indexOffset)[i].tick;
+}
+
+uint64_t Replay::keyframeHash(uint64_t i) const {
+  const Keyframe* index = reinterpret_cast<const Keyframe*>(data + header().indexOffset);
+
+  Engine engine;
+  memcpy(static_cast<void*>(&engine), data + index[i].stateOffset, sizeof(Engine));
+  return engine.hash();
+}
+
+bool Replay::step(Engine& engine, Cursor& cursor) const {
+  while (cursor.nextTick == engine.getTicks()) {
+    engine.input(cursor.nextInput);
+    readEvent(cursor);
+  }
+
+  // inputs on the last tick (like the hard drop that ended the game) still count, but the tick itself never happened.
+  // a recorded game only ends there, but a keyframe can't be trusted to agree, and a finished engine never ticks on.
+  if (engine.getTicks() >= length() || engine.over()) return false;
+
+  engine.tick();
+  return true;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "engine.hpp"
+#include <cstdint>
+#include <vector>
+
+// replay files: a header, the input events, full engine keyframes and an index of those keyframes, aligned to
+// its entries.
+//
+// each event is one byte, input in the low 3 bits and ticks since the previous event in the high 5.
+// a delta of 31 or more stores 31 and follows with the real delta as a varint.
+// keyframes let a reader jump close to any tick and only simulate the rest of the way.
+namespace Replays {
+  constexpr char MAGIC[4] = { 'T', 'R', 'P', 'L' };
+  constexpr uint32_t VERSION = 3;
+  // seconds of play between keyframes.
+  constexpr uint64_t KEYFRAME_INTERVAL = 10;
+  // a recording has room for this much play, at up to EVENTS_PER_SECOND bytes of events a second, from the start,
+  // so recording a game shorter than that never allocates while it's being played.
+  constexpr uint64_t RESERVED_SECONDS = 600;
+  constexpr uint64_t EVENTS_PER_SECOND = 16;
+
+  struct Header {
+    char magic[4];
+    uint32_t version;
+    // engines of a different layout can't load the keyframes.
+    uint32_t stateSize;
+    uint32_t randomizer;
+    uint32_t tickRate;
+    uint32_t reserved;
+    uint64_t seed;
+    uint64_t length;
+    uint64_t events;
+    int64_t score;
+    uint64_t eventsOffset;
+    uint64_t eventsSize;
+    uint64_t indexOffset;
+    uint64_t keyframes;
+  };
+
+  struct Keyframe {
+    uint64_t tick;
+    // where decoding resumes in the event stream, and the tick the next delta counts from.
+    uint64_t eventOffset;
+    uint64_t eventTick;
+    // where the saved engine sits in the file.
+    uint64_t stateOffset;
+  };
+}
+
+// collects a game as it is played. feed it every input and every tick, then save it.
+class ReplayRecorder {
+public:
+  // starts over from the engine's current state, which should be right before its first tick.
+  void begin(const Engine& engine, uint64_t seed, Randomizer randomizer);
+  void input(const Engine& engine, Input input);
+  // call after every Engine::tick().
+  void tick(const Engine& engine);
+  // takes the game back to an earlier state of itself, e.g. from a Rewind: forgets every input from the engine's
+  // tick on and keyframes it there, so the recording carries on from that point as if the rest never happened.
+  void rewind(const Engine& engine);
+
+  bool save(const char* path, const Engine& engine) const;
+
+  inline bool recording() const { return !keyframes.empty(); }
+private:
+  uint64_t seed;
+  Randomizer randomizer;
+  uint64_t lastTick;
+  uint64_t events;
+  int tickRate;
+
+  std::vector<uint8_t> stream;
+  std::vector<Replays::Keyframe> keyframes;
+  std::vector<Engine> states;
+};
+
+// a replay file mapped into memory. nothing is copied out of it besides the keyframe being restored.
+class Replay {
+public:
+  // where playback is up to in the event stream.
+  struct Cursor {
+    uint64_t offset;
+    uint64_t eventTick;
+    // tick of the next event, or ~0 once they have all been read.
+    uint64_t nextTick;
+    Input nextInput;
+  };
+
+  Replay();
+  ~Replay();
+
+  Replay(const Replay&) = delete;
+  Replay& operator=(const Replay&) = delete;
+
+  bool open(const char* path);
+  void close();
+
+  inline const Replays::Header& header() const { return *reinterpret_cast<const Replays::Header*>(data); }
+  inline uint64_t length() const { return header().length; }
+  inline uint64_t keyframes() const { return header().keyframes; }
+  // the tick keyframe i was taken at, and the Engine::hash() of the state saved there. a playback that hashes
+  // differently at that tick has strayed from the recording somewhere since the keyframe before.
+  uint64_t keyframeTick(uint64_t i) const;
+  uint64_t keyframeHash(uint64_t i) const;
+
+  // puts the engine at the start of the given tick, before that tick's inputs, from the closest keyframe at or before it.
+  void seek(Engine& engine, Cursor& cursor, uint64_t tick) const;
+  // applies the inputs of the engine's current tick and ticks it. returns false once the replay has ended.
+  bool step(Engine& engine, Cursor& cursor) const;
+private:
+  void readEvent(Cursor& cursor) const;
+
+  const uint8_t* data;
+  size_t size;
+};
@@ -0,0 +1,32 @@
+#include "rewind.hpp"
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable_v<Engine>, "Engine must stay trivially copyable to be snapshotted");
+
+void Rewind::reserve(int seconds, int tickRate) {
+  size_t slots = std::max(1, seconds * tickRate);
+  if (states.size() != slots) states.assign(slots, Engine());
+  clear();
+}
+
+void Rewind::clear() {
+  head = 0;
+  count = 0;
+}
+
+void Rewind::push(const Engine& engine) {
+  if (states.empty()) return;
+
+  states[head] = engine;
+  head = (head + 1) % states.size();
+  count = std::min<int>(count + 1, states.size());
+}
+
+bool Rewind::pop(Engine& engine) {
+  if (count == 0) return false;
+
+  head = (head + int(states.size()) - 1) % states.size();
+  count--;
+  engine = states[head];
+  return true;
+}
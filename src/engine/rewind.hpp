@@ -0,0 +1,26 @@
+#pragma once
+
+#include "engine.hpp"
+#include <vector>
+
+// the last few seconds of a game as whole engine copies, newest on top. the engine is a flat, trivially copyable
+// value (cells are a byte each, the generator holds no pointers), so a snapshot is one small memcpy.
+// every slot is allocated up front, so pushing during play never allocates; once full, the oldest is overwritten.
+class Rewind {
+public:
+  // room for seconds of play at tickRate ticks per second, one state per tick. forgets what was kept.
+  void reserve(int seconds, int tickRate);
+  void clear();
+
+  void push(const Engine& engine);
+  // moves the newest state into engine. returns false once there is nothing left to go back to.
+  bool pop(Engine& engine);
+
+  inline int size() const { return count; }
+  inline int capacity() const { return states.size(); }
+private:
+  std::vector<Engine> states;
+  // next slot written.
+  int head = 0;
+  int count = 0;
+};
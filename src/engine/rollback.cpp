@@ -0,0 +1,156 @@
+#include "rollback.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable_v<Match>, "Match must stay trivially copyable to be snapshotted");
+
+Match::Match(uint64_t seed): players{ Engine(seed), Engine(seed) }, frame(0) {}
+
+void Match::setTickRate(int rate) {
+  for (Engine& engine : players) engine.setTickRate(rate);
+}
+
+void Match::step(TickInput first, TickInput second) {
+  if (over()) return;
+  frame++;
+
+  first.each([&](Input input) { players[0].input(input); });
+  second.each([&](Input input) { players[1].input(input); });
+
+  for (Engine& engine : players) engine.tick();
+
+  // both are taken before either is given, so neither side goes first.
+  int sent[2] = { players[0].takeAttack(), players[1].takeAttack() };
+  players[0].addGarbage(sent[1]);
+  players[1].addGarbage(sent[0]);
+}
+
+Rollback::Rollback(uint64_t seed, int side) {
+  start(seed, side);
+}
+
+void Rollback::start(uint64_t seed, int side, int tickRate) {
+  session = seed;
+  local = side;
+
+  current = Match(seed);
+  current.setTickRate(tickRate);
+
+  localInputs.fill({});
+  remoteInputs.fill({});
+  frame = 0;
+  remoteFrames = 0;
+  acknowledged = 0;
+  rollbackFrom = ~0ull;
+  remoteChecked = ~0ull;
+  remoteChecksum = 0;
+  counters = {};
+  counters.firstDesync = ~0ull;
+}
+
+bool Rollback::advance(TickInput input) {
+  if (frame >= remoteFrames + WINDOW) {
+    counters.stalls++;
+    return false;
+  }
+
+  localInputs[frame % HISTORY] = input;
+  simulate(frame++);
+  return true;
+}
+
+void Rollback::send(Transport& transport) {
+  Packet packet;
+  packet.session = session;
+  packet.start = uint32_t(std::max<uint64_t>(acknowledged, frame > HISTORY ? frame - HISTORY : 0));
+  packet.received = uint32_t(remoteFrames);
+  packet.count = uint32_t(frame - packet.start);
+  packet.checked = uint32_t(confirmed());
+  packet.checksum = stateAt(confirmed()).hash();
+
+  for (uint32_t i = 0; i < packet.count; i++)
+    packet.inputs[i] = localInputs[(packet.start + i) % HISTORY];
+
+  // only the inputs in use go on the wire.
+  transport.send(&packet, offsetof(Packet, inputs) + packet.count * sizeof(TickInput));
+}
+
+int Rollback::poll(Transport& transport) {
+  Packet packet;
+  while (size_t size = transport.receive(&packet, sizeof(packet)))
+    receive(packet, size);
+
+  int replayed = replay();
+  verify();
+  return replayed;
+}
+
+int Rollback::replay() {
+  if (rollbackFrom >= frame) return 0;
+
+  // back to the first tick that went wrong, then forward again with what is known now.
+  current = snapshots[rollbackFrom % HISTORY];
+  int replayed = int(frame - rollbackFrom);
+  for (uint64_t at = rollbackFrom; at < frame; at++) simulate(at);
+
+  rollbackFrom = ~0ull;
+  counters.rollbacks++;
+  counters.resimulated += replayed;
+  counters.worst = std::max(counters.worst, replayed);
+  return replayed;
+}
+
+void Rollback::receive(const Packet& packet, size_t size) {
+  if (size < offsetof(Packet, inputs) || packet.session != session || packet.count > HISTORY) return;
+  if (size < offsetof(Packet, inputs) + packet.count * sizeof(TickInput)) return;
+
+  acknowledged = std::clamp<uint64_t>(packet.received, acknowledged, frame);
+  if (remoteChecked == ~0ull || packet.checked > remoteChecked) {
+    remoteChecked = packet.checked;
+    remoteChecksum = packet.checksum;
+  }
+
+  // inputs are only taken in order. anything after a gap waits for a later packet, which repeats it.
+  for (uint32_t i = 0; i < packet.count; i++) {
+    uint64_t at = packet.start + i;
+    if (at < remoteFrames) continue;
+    if (at > remoteFrames || at >= frame + WINDOW) break;
+
+    TickInput input = packet.inputs[i];
+    remoteInputs[at % HISTORY] = input;
+    remoteFrames++;
+
+    // ticks already played guessed this side pressed nothing.
+    if (at < frame && !input.empty()) rollbackFrom = std::min(rollbackFrom, at);
+  }
+}
+
+TickInput Rollback::remoteInput(uint64_t at) const {
+  return at < remoteFrames ? remoteInputs[at % HISTORY] : TickInput();
+}
+
+void Rollback::verify() {
+  // too new to know for certain here yet, or too old to still have; a later packet brings another.
+  if (remoteChecked > confirmed() || remoteChecked + HISTORY <= frame) return;
+
+  if (stateAt(remoteChecked).hash() != remoteChecksum) {
+    counters.desyncs++;
+    counters.firstDesync = std::min(counters.firstDesync, remoteChecked);
+  }
+
+  remoteChecked = ~0ull;
+}
+
+const Match& Rollback::stateAt(uint64_t at) const {
+  return at == frame ? current : snapshots[at % HISTORY];
+}
+
+void Rollback::simulate(uint64_t at) {
+  snapshots[at % HISTORY] = current;
+
+  TickInput mine = localInputs[at % HISTORY], theirs = remoteInput(at);
+  if (local == 0) current.step(mine, theirs);
+  else current.step(theirs, mine);
+}
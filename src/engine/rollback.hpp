@@ -0,0 +1,155 @@
+#pragma once
+
+#include "engine.hpp"
+#include "transport.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+// one player's inputs for one tick, in the order they happened: 4 bits each, holding input + 1, with 0 ending the list.
+struct TickInput {
+  static constexpr int MAX = 8;
+
+  uint32_t packed = 0;
+
+  // false once the tick already holds MAX inputs.
+  inline bool add(Input input) {
+    for (int i = 0; i < MAX; i++) {
+      if (packed >> (i * 4) & 0xf) continue;
+
+      packed |= uint32_t(input + 1) << (i * 4);
+      return true;
+    }
+
+    return false;
+  }
+
+  template <typename Fn>
+  inline void each(Fn fn) const {
+    for (uint32_t rest = packed; rest & 0xf; rest >>= 4) fn(static_cast<Input>((rest & 0xf) - 1));
+  }
+
+  inline bool empty() const { return packed == 0; }
+};
+
+// two engines dealt the same blocks, side by side, each one's line clears sending garbage to the other.
+// a flat value like Engine, so a whole match is snapshotted with one copy.
+class Match {
+public:
+  explicit Match(uint64_t seed = 0);
+
+  void setTickRate(int rate);
+
+  // one tick: each player's inputs, then both engines tick, then whatever garbage either side sent changes sides.
+  // does nothing once the match is over, so the frame count stays at the tick it ended on.
+  void step(TickInput first, TickInput second);
+
+  inline const Engine& player(int side) const { return players[side]; }
+  inline uint64_t getFrame() const { return frame; }
+  // both players' Engine::hash(), told apart by side.
+  inline uint64_t hash() const { return players[0].hash() ^ Zobrist::mix(players[1].hash() + 1); }
+  // over as soon as either side has topped out.
+  inline bool over() const { return players[0].over() || players[1].over(); }
+private:
+  std::array<Engine, 2> players;
+  uint64_t frame;
+};
+
+// runs a match against a player on the other end of a Transport without waiting on them. the remote side is
+// predicted to press nothing; when its real inputs for a tick already played turn out otherwise, the match goes back
+// to a snapshot of that tick and plays forward again, all within the one update. runs ahead of the last remote
+// input by at most WINDOW ticks, and waits there, so a rollback never has more than that to redo.
+// each packet also carries the hash of the latest state its sender knows for certain, which the receiver checks
+// against its own state for the same frame, so a desync is noticed within a round trip.
+class Rollback {
+public:
+  static constexpr int WINDOW = 16;
+  // snapshots and inputs kept. each side can be up to WINDOW ticks ahead of the other, so twice that covers both.
+  static constexpr int HISTORY = WINDOW * 2;
+
+  // what each side sends every tick: its recent inputs and how many of the other side's it has.
+  // raw bytes on the wire, so both ends must be the same build.
+  struct Packet {
+    // the match seed, so stray datagrams from another match are ignored.
+    uint64_t session;
+    // frame of inputs[0].
+    uint32_t start;
+    // frames of the receiver's input the sender has.
+    uint32_t received;
+    uint32_t count;
+    // Match::hash() at the start of frame checked, a frame both sides' inputs before it are known for.
+    uint32_t checked;
+    uint64_t checksum;
+    std::array<TickInput, HISTORY> inputs;
+  };
+
+  struct Stats {
+    uint64_t rollbacks;
+    uint64_t resimulated;
+    // most ticks played again by a single update.
+    int worst;
+    // updates the local side had to sit out, too far ahead of the remote one.
+    uint64_t stalls;
+    // checksums from the other side that didn't match this side's state, and the first frame one was for.
+    uint64_t desyncs;
+    uint64_t firstDesync;
+  };
+
+  explicit Rollback(uint64_t seed = 0, int side = 0);
+
+  // a new match between the same two sides. side is this end's player, 0 or 1, the other end must be the other.
+  void start(uint64_t seed, int side, int tickRate = Rules::TICK_RATE);
+
+  // plays the next tick with the local input. returns false, keeping nothing, while WINDOW ticks ahead.
+  bool advance(TickInput input);
+  // sends the inputs the other side hasn't confirmed yet.
+  void send(Transport& transport);
+  // takes every datagram waiting, then plays again from the earliest tick whose prediction was wrong, then checks
+  // the other side's checksum. returns the ticks played again.
+  int poll(Transport& transport);
+
+  inline const Match& match() const { return current; }
+  inline int side() const { return local; }
+  inline uint64_t getFrame() const { return frame; }
+  // both sides' inputs are known up to now, or up to where the match ended, so it won't change any more.
+  inline bool settled() const {
+    return remoteFrames >= frame || (current.over() && remoteFrames >= current.getFrame());
+  }
+  inline const Stats& stats() const { return counters; }
+private:
+  void receive(const Packet& packet, size_t size);
+  // goes back to rollbackFrom, if a prediction was wrong, and plays forward again. returns the ticks played again.
+  int replay();
+  // compares the last checksum received against this side's state for that frame, once it is known.
+  void verify();
+  TickInput remoteInput(uint64_t at) const;
+  // the state at the start of frame at, which must be no later than now and at most HISTORY frames back.
+  const Match& stateAt(uint64_t at) const;
+  // the latest frame both sides' inputs are known before, so its state is final.
+  inline uint64_t confirmed() const { return std::min(frame, remoteFrames); }
+  // plays frame at from the stored inputs, saving the state before it.
+  void simulate(uint64_t at);
+
+  uint64_t session;
+  int local;
+
+  Match current;
+  // the state at the start of frame f is at f % HISTORY, and so are the inputs of that frame.
+  std::array<Match, HISTORY> snapshots;
+  std::array<TickInput, HISTORY> localInputs;
+  std::array<TickInput, HISTORY> remoteInputs;
+
+  // next frame to play.
+  uint64_t frame;
+  // remote inputs are known for every frame before this one.
+  uint64_t remoteFrames;
+  // the remote side has every local input before this one.
+  uint64_t acknowledged;
+  // earliest frame played with a wrong prediction, or ~0.
+  uint64_t rollbackFrom;
+  // the newest checksum received, checked once whatever arrived with it has been played.
+  uint64_t remoteChecked;
+  uint64_t remoteChecksum;
+
+  Stats counters;
+};
@@ -0,0 +1,134 @@
+#include "task_pool.hpp"
+#include <algorithm>
+
+static thread_local unsigned currentWorker = ~0u;
+
+TaskPool::TaskPool(unsigned threads): queues(std::max(threads, 1u)), pending(0), stopping(false) {
+  // the thread calling parallelFor makes up the last one.
+  for (unsigned i = 0; i + 1 < queues.size(); i++)
+    workers.emplace_back(&TaskPool::loop, this, i);
+}
+
+TaskPool::~TaskPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    stopping = true;
+  }
+
+  wake.notify_all();
+  for (std::thread& worker : workers) worker.join();
+}
+
+unsigned TaskPool::worker() {
+  return currentWorker;
+}
+
+void TaskPool::parallelFor(int count, const std::function<void(int)>& fn) {
+  if (count <= 0) return;
+
+  unsigned self = queues.size() - 1;
+  unsigned previous = currentWorker;
+  currentWorker = self;
+
+  // a few chunks per thread is enough to even out the load without paying for a task per index.
+  int chunks = std::min<int>(count, queues.size() * 4);
+  std::atomic<int> remaining(chunks);
+  int queued = 0;
+
+  for (int chunk = 0; chunk < chunks; chunk++) {
+    Task task = { &fn, count * chunk / chunks, count * (chunk + 1) / chunks, &remaining };
+    Queue& queue = queues[chunk % queues.size()];
+
+    bool pushed;
+    {
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      pushed = queue.pushBack(task);
+    }
+
+    if (pushed) queued++;
+    else {
+      for (int i = task.begin; i < task.end; i++) fn(i);
+      remaining.fetch_sub(1, std::memory_order_release);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    pending += queued;
+  }
+  wake.notify_all();
+
+  Task task;
+  while (remaining.load(std::memory_order_acquire) > 0) {
+    if (take(self, task)) run(task);
+    else std::this_thread::yield();
+  }
+
+  currentWorker = previous;
+}
+
+bool TaskPool::Queue::pushBack(const Task& task) {
+  if (count == CAPACITY) return false;
+
+  tasks[(first + count++) % CAPACITY] = task;
+  return true;
+}
+
+bool TaskPool::Queue::popBack(Task& task) {
+  if (count == 0) return false;
+
+  task = tasks[(first + --count) % CAPACITY];
+  return true;
+}
+
+bool TaskPool::Queue::popFront(Task& task) {
+  if (count == 0) return false;
+
+  task = tasks[first];
+  first = (first + 1) % CAPACITY;
+  count--;
+  return true;
+}
+
+bool TaskPool::take(unsigned self, Task& task) {
+  {
+    Queue& own = queues[self];
+    std::lock_guard<std::mutex> lock(own.mutex);
+
+    if (own.popBack(task)) return true;
+  }
+
+  for (unsigned i = 1; i < queues.size(); i++) {
+    Queue& victim = queues[(self + i) % queues.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+
+    if (victim.popFront(task)) return true;
+  }
+
+  return false;
+}
+
+void TaskPool::run(const Task& task) {
+  pending--;
+
+  for (int i = task.begin; i < task.end; i++)
+    (*task.fn)(i);
+
+  task.remaining->fetch_sub(1, std::memory_order_release);
+}
+
+void TaskPool::loop(unsigned self) {
+  currentWorker = self;
+  Task task;
+
+  while (true) {
+    if (take(self, task)) {
+      run(task);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    wake.wait(lock, [this] { return stopping || pending > 0; });
+    if (stopping) return;
+  }
+}
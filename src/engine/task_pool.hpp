@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of worker threads, each with its own task queue. workers take work from the back of their
+// own queue and steal from the front of everyone else's, so uneven tasks still keep every core busy.
+// the queues are fixed rings, so handing out work never allocates.
+class TaskPool {
+public:
+  explicit TaskPool(unsigned threads = std::thread::hardware_concurrency());
+  ~TaskPool();
+
+  TaskPool(const TaskPool&) = delete;
+  TaskPool& operator=(const TaskPool&) = delete;
+
+  // runs fn(i) for every i in [0, count) and returns once all of them have finished.
+  // the calling thread works through tasks too, instead of just waiting.
+  void parallelFor(int count, const std::function<void(int)>& fn);
+
+  // number of threads that can run tasks at once, including a caller inside parallelFor.
+  inline unsigned size() const { return workers.size() + 1; }
+
+  // index in [0, size()) of the thread running the current task, for per-thread scratch space.
+  // the caller of parallelFor is always the last index.
+  static unsigned worker();
+private:
+  struct Task {
+    const std::function<void(int)>* fn;
+    int begin, end;
+    std::atomic<int>* remaining;
+  };
+
+  struct Queue {
+    // a parallelFor puts at most 4 tasks in each queue, so this only fills up with many callers at once.
+    // tasks that don't fit are run by their caller there and then.
+    static constexpr int CAPACITY = 64;
+
+    std::mutex mutex;
+    std::array<Task, CAPACITY> tasks;
+    // tasks[first] is the front, and count follow it around the ring.
+    int first = 0;
+    int count = 0;
+
+    bool pushBack(const Task& task);
+    bool popBack(Task& task);
+    bool popFront(Task& task);
+  };
+
+  bool take(unsigned self, Task& task);
+  void run(const Task& task);
+  void loop(unsigned self);
+
+  std::vector<std::thread> workers;
+  std::vector<Queue> queues;
+
+  std::mutex sleepMutex;
+  std::condition_variable wake;
+  std::atomic<int> pending;
+  bool stopping;
+};
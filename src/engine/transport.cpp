@@ -0,0 +1,130 @@
+#include "transport.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+UdpTransport::UdpTransport(): socket(-1), peer{}, hasPeer(false) {}
+
+UdpTransport::~UdpTransport() { close(); }
+
+bool UdpTransport::open() {
+  if (socket >= 0) return true;
+
+  socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+  if (socket < 0) return false;
+
+  if (fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) | O_NONBLOCK) != 0) {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+bool UdpTransport::listen(uint16_t port) {
+  if (!open()) return false;
+
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+
+  return bind(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+}
+
+bool UdpTransport::connect(const char* host, uint16_t port) {
+  if (!open()) return false;
+
+  addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+
+  addrinfo* found = nullptr;
+  if (getaddrinfo(host, nullptr, &hints, &found) != 0 || !found) return false;
+
+  memcpy(&peer, found->ai_addr, sizeof(peer));
+  peer.sin_port = htons(port);
+  freeaddrinfo(found);
+
+  hasPeer = true;
+  return true;
+}
+
+void UdpTransport::close() {
+  if (socket >= 0) ::close(socket);
+  socket = -1;
+  hasPeer = false;
+}
+
+void UdpTransport::send(const void* data, size_t size) {
+  if (socket < 0 || !hasPeer) return;
+  // a full send buffer is just another lost datagram.
+  sendto(socket, data, size, 0, reinterpret_cast<const sockaddr*>(&peer), sizeof(peer));
+}
+
+size_t UdpTransport::receive(void* data, size_t capacity) {
+  if (socket < 0) return 0;
+
+  sockaddr_in from = {};
+  socklen_t fromSize = sizeof(from);
+  ssize_t size = recvfrom(socket, data, capacity, 0, reinterpret_cast<sockaddr*>(&from), &fromSize);
+  if (size <= 0) return 0;
+
+  if (!hasPeer) {
+    peer = from;
+    hasPeer = true;
+  }
+
+  return size_t(size);
+}
+
+SimulatedLink::SimulatedLink(LinkSettings settings, uint64_t seed):
+  config(settings),
+  random(seed),
+  now(0)
+{
+  for (int side = 0; side < 2; side++) {
+    ends[side].link = this;
+    ends[side].side = side;
+    inFlight[side].reserve(1024);
+  }
+}
+
+void SimulatedLink::clear() {
+  for (std::vector<Datagram>& datagrams : inFlight) datagrams.clear();
+}
+
+void SimulatedLink::End::send(const void* data, size_t size) {
+  if (size > MAX_DATAGRAM) return;
+
+  Xoshiro256& random = link->random;
+  if (link->config.loss > 0 && int(random.below(100)) < link->config.loss) return;
+
+  uint64_t delay = uint64_t(link->config.latency) * 1000;
+  if (link->config.jitter > 0) delay += random.below(link->config.jitter * 1000 + 1);
+
+  Datagram& datagram = link->inFlight[1 - side].emplace_back();
+  datagram.due = link->now + delay;
+  datagram.size = size;
+  memcpy(datagram.data.data(), data, size);
+}
+
+size_t SimulatedLink::End::receive(void* data, size_t capacity) {
+  std::vector<Datagram>& datagrams = link->inFlight[side];
+
+  // the earliest due, so jitter can reorder datagrams but a late one doesn't hold up the rest.
+  auto next = std::min_element(datagrams.begin(), datagrams.end(),
+    [](const Datagram& a, const Datagram& b) { return a.due < b.due; });
+  if (next == datagrams.end() || next->due > link->now) return 0;
+
+  size_t size = std::min(next->size, capacity);
+  memcpy(data, next->data.data(), size);
+
+  *next = datagrams.back();
+  datagrams.pop_back();
+  return size;
+}
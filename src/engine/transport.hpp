@@ -0,0 +1,97 @@
+#pragma once
+
+#include "randomizer.hpp"
+#include "../constants.hpp"
+#include <netinet/in.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// carries datagrams between the two sides of a versus match. nothing is promised: a datagram may arrive late,
+// out of order or not at all, and whatever sits on top has to cope.
+class Transport {
+public:
+  virtual ~Transport() = default;
+
+  virtual void send(const void* data, size_t size) = 0;
+  // copies the next datagram that has arrived into data and returns its size, or 0 if none has.
+  virtual size_t receive(void* data, size_t capacity) = 0;
+};
+
+// a non-blocking UDP socket, IPv4 only.
+class UdpTransport : public Transport {
+public:
+  UdpTransport();
+  ~UdpTransport();
+
+  UdpTransport(const UdpTransport&) = delete;
+  UdpTransport& operator=(const UdpTransport&) = delete;
+
+  // takes datagrams sent to port on any interface. without a peer it answers whoever sends to it first.
+  bool listen(uint16_t port);
+  // sends to host:port from now on, listening on any free port if listen() wasn't called.
+  bool connect(const char* host, uint16_t port);
+  void close();
+
+  void send(const void* data, size_t size) override;
+  size_t receive(void* data, size_t capacity) override;
+private:
+  bool open();
+
+  int socket;
+  sockaddr_in peer;
+  bool hasPeer;
+};
+
+struct LinkSettings {
+  // milliseconds each way, the most a datagram may come later than that, and the percentage dropped.
+  int latency = Versus::LATENCY;
+  int jitter = Versus::JITTER;
+  int loss = Versus::LOSS;
+};
+
+// an in-process network between two ends, with latency, jitter and loss, for trying netcode on one machine.
+// its clock is whatever the caller sets, so a run can go faster than real time and come out the same every time.
+class SimulatedLink {
+public:
+  static constexpr size_t MAX_DATAGRAM = 256;
+
+  explicit SimulatedLink(LinkSettings settings = {}, uint64_t seed = 0);
+
+  SimulatedLink(const SimulatedLink&) = delete;
+  SimulatedLink& operator=(const SimulatedLink&) = delete;
+
+  // microseconds. datagrams come out of the far end once this passes the time they are due.
+  inline void setTime(uint64_t microseconds) { now = microseconds; }
+  // takes effect for datagrams sent from now on.
+  inline void configure(const LinkSettings& settings) { config = settings; }
+  // drops everything in flight.
+  void clear();
+
+  inline Transport& end(int side) { return ends[side]; }
+  inline const LinkSettings& settings() const { return config; }
+private:
+  struct Datagram {
+    uint64_t due;
+    size_t size;
+    std::array<uint8_t, MAX_DATAGRAM> data;
+  };
+
+  class End : public Transport {
+  public:
+    void send(const void* data, size_t size) override;
+    size_t receive(void* data, size_t capacity) override;
+
+    SimulatedLink* link;
+    int side;
+  };
+
+  LinkSettings config;
+  Xoshiro256 random;
+  uint64_t now;
+
+  // what is on its way to each end, in no particular order. room is reserved up front.
+  std::array<std::vector<Datagram>, 2> inFlight;
+  std::array<End, 2> ends;
+};
@@ -0,0 +1,41 @@
+#include "transposition.hpp"
+#include <algorithm>
+#include <bit>
+
+TranspositionTable::TranspositionTable(size_t capacity):
+  entries(new Entry[std::bit_ceil(std::max<size_t>(capacity, 1))]),
+  mask(std::bit_ceil(std::max<size_t>(capacity, 1)) - 1)
+{
+  clear();
+}
+
+void TranspositionTable::clear() {
+  for (size_t i = 0; i <= mask; i++) {
+    entries[i].tag.store(0, std::memory_order_relaxed);
+    entries[i].data.store(0, std::memory_order_relaxed);
+  }
+}
+
+void TranspositionTable::store(uint64_t key, uint64_t data) {
+  Entry& entry = entries[key & mask];
+  entry.tag.store(tagOf(key) ^ data, std::memory_order_relaxed);
+  entry.data.store(data, std::memory_order_relaxed);
+}
+
+bool TranspositionTable::probe(uint64_t key, uint64_t& data) const {
+  const Entry& entry = entries[key & mask];
+  uint64_t tag = entry.tag.load(std::memory_order_relaxed);
+  uint64_t value = entry.data.load(std::memory_order_relaxed);
+
+  if ((tag ^ value) != tagOf(key)) return false;
+
+  data = value;
+  return true;
+}
+
+bool TranspositionTable::visit(uint64_t key) {
+  Entry& entry = entries[key & mask];
+  bool fresh = entry.tag.exchange(tagOf(key), std::memory_order_relaxed) != tagOf(key);
+  if (fresh) entry.data.store(0, std::memory_order_relaxed);
+  return fresh;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// a fixed-size hash table from 64-bit position hashes (see Zobrist) to 64 bits of whatever the caller wants kept,
+// shared between threads without locks. each slot holds one entry and a newer one simply replaces it, so a lookup
+// can miss something stored earlier. the tag kept with the data is the key xor the data, so a slot torn between two
+// writers fails the check (short of a 64-bit collision) rather than answering with another key's data.
+// see: https://www.cis.uab.edu/hyatt/hashing.html
+class TranspositionTable {
+public:
+  // rounded up to a power of two.
+  explicit TranspositionTable(size_t capacity);
+
+  TranspositionTable(const TranspositionTable&) = delete;
+  TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+  // not safe while other threads use the table.
+  void clear();
+
+  void store(uint64_t key, uint64_t data);
+  // true, with the data, if key was the last stored in its slot.
+  bool probe(uint64_t key, uint64_t& data) const;
+  // stores key with no data and returns whether it was new, i.e. not the last key stored in its slot.
+  // when two threads visit the same key at once, exactly one of them sees it as new. meant for tables that only
+  // record what has been seen: a key stored with data counts as new here.
+  bool visit(uint64_t key);
+
+  inline size_t size() const { return mask + 1; }
+private:
+  struct Entry {
+    std::atomic<uint64_t> tag;
+    std::atomic<uint64_t> data;
+  };
+
+  // 0 marks an empty slot, so keys are stored with the low bit set. the bit is still used to find the slot.
+  static inline uint64_t tagOf(uint64_t key) { return key | 1; }
+
+  std::unique_ptr<Entry[]> entries;
+  size_t mask;
+};
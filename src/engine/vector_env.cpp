@@ -0,0 +1,108 @@
+#include "vector_env.hpp"
+#include <algorithm>
+
+VectorEnv::VectorEnv(int count, uint64_t seed, int threads):
+  engines(std::max(count, 1)),
+  seeds(engines.size()),
+  shardFn(nullptr),
+  shards(1),
+  actions(nullptr),
+  out{}
+{
+  for (size_t i = 0; i < engines.size(); i++) seeds[i] = seed + i;
+
+  if (threads > 1) {
+    pool = std::make_unique<TaskPool>(threads);
+    // a few slices per thread, so one slow slice doesn't hold up the call.
+    shards = std::min<int>(engines.size(), pool->size() * 4);
+  }
+
+  shard = [this](int i) {
+    (this->*shardFn)(size() * i / shards, size() * (i + 1) / shards);
+  };
+}
+
+void VectorEnv::reset(const Buffers& out) {
+  this->out = out;
+  forEach(&VectorEnv::resetRange);
+}
+
+void VectorEnv::step(const int32_t* actions, const Buffers& out) {
+  this->actions = actions;
+  this->out = out;
+  forEach(&VectorEnv::stepRange);
+}
+
+void VectorEnv::forEach(void (VectorEnv::*fn)(int, int)) {
+  if (!pool) {
+    (this->*fn)(0, size());
+    return;
+  }
+
+  shardFn = fn;
+  pool->parallelFor(shards, shard);
+}
+
+void VectorEnv::resetRange(int begin, int end) {
+  for (int i = begin; i < end; i++) {
+    restart(i);
+    out.reward[i] = 0;
+    out.done[i] = 0;
+    observe(i);
+  }
+}
+
+void VectorEnv::stepRange(int begin, int end) {
+  for (int i = begin; i < end; i++) {
+    Engine& engine = engines[i];
+    int score = engine.getScore();
+    int action = actions[i];
+
+    if (action == HOLD) engine.input(Input::Hold);
+    else {
+      if (action >= 0 && action < HOLD) {
+        for (int turn = 0; turn < action / COLUMNS; turn++) engine.rotate(1);
+
+        // walks the leftmost tile towards the column, stopping early against the stack or a wall.
+        auto left = [&]() {
+          int x = COLUMNS;
+          for (const Coords& tile : Pieces::cells(engine.block())) x = std::min(x, tile.x);
+          return x;
+        };
+
+        int column = action % COLUMNS;
+        while (left() < column && engine.moveHorizontal(1));
+        while (left() > column && engine.moveHorizontal(-1));
+      }
+
+      engine.input(Input::HardDrop);
+    }
+
+    out.reward[i] = float(engine.getScore() - score);
+    out.done[i] = engine.over();
+    if (engine.over()) restart(i);
+
+    observe(i);
+  }
+}
+
+void VectorEnv::restart(int i) {
+  engines[i].seed(seeds[i]);
+  engines[i].reset();
+  seeds[i] += engines.size();
+}
+
+void VectorEnv::observe(int i) {
+  const Engine& engine = engines[i];
+  const Board& board = engine.getBoard();
+
+  uint8_t* cells = out.board + size_t(i) * BOARD_SIZE;
+  for (int y = 0; y < ROWS; y++) {
+    Board::Row row = board.bits(y) >> Board::WALL;
+    for (int x = 0; x < COLUMNS; x++) cells[y * COLUMNS + x] = row >> x & 1;
+  }
+
+  out.piece[i] = engine.block().type;
+  out.hold[i] = engine.getHold();
+  for (int n = 0; n < Rules::PREVIEW; n++) out.next[size_t(i) * Rules::PREVIEW + n] = engine.getNext(n);
+}
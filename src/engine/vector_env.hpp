@@ -0,0 +1,74 @@
+#pragma once
+
+#include "engine.hpp"
+#include "pieces.hpp"
+#include "task_pool.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+
+// N independent games stepped together, a block placement per step, for training agents.
+// every action places the active block: rotation * COLUMNS + column rotates it clockwise that many times, moves its
+// leftmost tile as close to column as it will go and hard drops it. HOLD swaps it with the held block instead.
+// finished games start over by themselves, each with a seed of its own.
+class VectorEnv {
+public:
+  static constexpr int HOLD = Pieces::ROTATIONS * COLUMNS;
+  static constexpr int ACTIONS = HOLD + 1;
+  static constexpr int BOARD_SIZE = COLUMNS * ROWS;
+
+  // where step() and reset() write, one array per field with an entry per environment (struct of arrays).
+  // the caller owns every buffer; nothing is copied out of them or allocated for them.
+  struct Buffers {
+    // COLUMNS * ROWS per environment, 1 where a tile is filled. row 0 is the bottom one, only visible rows are included.
+    uint8_t* board;
+    // the active block's BlockType, and the held one (0 for none).
+    int8_t* piece;
+    int8_t* hold;
+    // Rules::PREVIEW per environment, soonest first.
+    int8_t* next;
+    // score gained by the step, as the engine scores line clears.
+    float* reward;
+    // 1 if the step ended the game. that environment has been reset already, so its observation is of the new game.
+    uint8_t* done;
+  };
+
+  // threads > 1 splits the environments across that many threads (the caller's included) on every call.
+  VectorEnv(int count, uint64_t seed, int threads = 1);
+
+  VectorEnv(const VectorEnv&) = delete;
+  VectorEnv& operator=(const VectorEnv&) = delete;
+
+  // starts every game over and writes their first observations. rewards and done flags are zeroed.
+  void reset(const Buffers& out);
+  // applies actions[i] to game i and writes the results. actions out of range just hard drop.
+  void step(const int32_t* actions, const Buffers& out);
+
+  inline int size() const { return int(engines.size()); }
+  inline const Engine& engine(int i) const { return engines[i]; }
+private:
+  // runs fn(begin, end) over slices of the environments, across the pool if there is one.
+  void forEach(void (VectorEnv::*fn)(int, int));
+
+  void resetRange(int begin, int end);
+  void stepRange(int begin, int end);
+
+  void restart(int i);
+  void observe(int i);
+
+  std::vector<Engine> engines;
+  // seed of each game's next restart. game i is dealt seed + i, then seed + i + count, and so on.
+  std::vector<uint64_t> seeds;
+
+  std::unique_ptr<TaskPool> pool;
+  // built once, since a std::function capturing more than a pointer or two allocates.
+  std::function<void(int)> shard;
+  void (VectorEnv::*shardFn)(int, int);
+  int shards;
+
+  // the call in progress.
+  const int32_t* actions;
+  Buffers out;
+};
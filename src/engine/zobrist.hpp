@@ -0,0 +1,46 @@
+#pragma once
+
+#include "block.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// random keys for hashing positions. a position's hash is the xor of the keys of everything in it, so a change only
+// xors out the keys of what went and xors in those of what replaced it, whatever the rest of the position is.
+// see: https://www.chessprogramming.org/Zobrist_Hashing
+namespace Zobrist {
+  // coordinates are looked up modulo this, which is more than any field (walls and sky included) spans.
+  constexpr int SPAN = 64;
+
+  // splitmix64's finalizer: every input bit flips about half the output bits.
+  constexpr uint64_t mix(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+  }
+
+  template <size_t N>
+  constexpr std::array<uint64_t, N> keys(uint64_t salt) {
+    std::array<uint64_t, N> out = {};
+    for (size_t i = 0; i < N; i++) out[i] = mix(salt * 0x9e3779b97f4a7c15ull + i + 1);
+    return out;
+  }
+
+  // a filled tile at [y * SPAN + x].
+  inline constexpr std::array<uint64_t, SPAN * SPAN> CELLS = keys<SPAN * SPAN>(1);
+  // the active block, by [type * 4 + rotation], column and row.
+  inline constexpr std::array<uint64_t, 8 * 4> PIECES = keys<8 * 4>(2);
+  inline constexpr std::array<uint64_t, SPAN> COLUMNS = keys<SPAN>(3);
+  inline constexpr std::array<uint64_t, SPAN> ROWS = keys<SPAN>(4);
+  // the held block by type, None included.
+  inline constexpr std::array<uint64_t, 8> HOLD = keys<8>(5);
+  inline constexpr uint64_t HOLD_LOCKED = mix(6);
+
+  inline uint64_t cell(int x, int y) {
+    return CELLS[(y & (SPAN - 1)) * SPAN + (x & (SPAN - 1))];
+  }
+
+  inline uint64_t block(const Block& block) {
+    return PIECES[block.type * 4 + (block.rotation & 3)] ^ COLUMNS[block.x & (SPAN - 1)] ^ ROWS[block.y & (SPAN - 1)];
+  }
+}
@@ -0,0 +1,44 @@
+#include "env.h"
+#include "../engine/vector_env.hpp"
+
+static_assert(ENV_COLUMNS == COLUMNS && ENV_ROWS == ROWS && ENV_PREVIEW == Rules::PREVIEW, "env.h is out of date");
+static_assert(ENV_HOLD == VectorEnv::HOLD && ENV_ACTIONS == VectorEnv::ACTIONS, "env.h is out of date");
+
+struct Env {
+  Env(int count, uint64_t seed, int threads): games(count, seed, threads) {}
+
+  VectorEnv games;
+};
+
+// the same six pointers, so this is free.
+static VectorEnv::Buffers buffers(const EnvBuffers* out) {
+  return { out->board, out->piece, out->hold, out->next, out->reward, out->done };
+}
+
+// nothing may be thrown back into C. making an Env is the only call that allocates or starts threads, and the games'
+// vectors and the pool can fail as well as the Env itself, so all of it is caught. stepping and resetting don't.
+Env* envCreate(int count, uint64_t seed, int threads) {
+  if (count <= 0) return nullptr;
+
+  try {
+    return new Env(count, seed, threads);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void envDestroy(Env* env) {
+  delete env;
+}
+
+int envCount(const Env* env) {
+  return env->games.size();
+}
+
+void envReset(Env* env, const EnvBuffers* out) {
+  env->games.reset(buffers(out));
+}
+
+void envStep(Env* env, const int32_t* actions, const EnvBuffers* out) {
+  env->games.step(actions, buffers(out));
+}
@@ -0,0 +1,45 @@
+/* C interface to VectorEnv (src/engine/vector_env.hpp), built as a shared library by `make env`.
+   N games are stepped by one call, a block placement each, with results written into buffers the caller owns. */
+
+#ifndef TETRIS_ENV_H
+#define TETRIS_ENV_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ENV_COLUMNS 10
+#define ENV_ROWS 20
+#define ENV_PREVIEW 5
+/* actions are rotation * ENV_COLUMNS + column, rotations counted clockwise, or ENV_HOLD. */
+#define ENV_HOLD (4 * ENV_COLUMNS)
+#define ENV_ACTIONS (ENV_HOLD + 1)
+
+/* one array per field, count entries each (times the sizes given). see VectorEnv::Buffers. */
+typedef struct {
+  uint8_t* board;   /* count * ENV_ROWS * ENV_COLUMNS, row 0 at the bottom */
+  int8_t* piece;    /* count */
+  int8_t* hold;     /* count, 0 for none */
+  int8_t* next;     /* count * ENV_PREVIEW */
+  float* reward;    /* count */
+  uint8_t* done;    /* count, the game has already been restarted when set */
+} EnvBuffers;
+
+typedef struct Env Env;
+
+/* threads > 1 splits every call across that many threads. returns NULL if it can't be made. */
+Env* envCreate(int count, uint64_t seed, int threads);
+void envDestroy(Env* env);
+int envCount(const Env* env);
+
+void envReset(Env* env, const EnvBuffers* out);
+/* actions holds count entries. */
+void envStep(Env* env, const int32_t* actions, const EnvBuffers* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
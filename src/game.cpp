@@ -1,31 +1,37 @@
 #include "game.hpp"
-#include "kick_map.hpp"
+#include "engine/pieces.hpp"
 #include <iostream>
+#include <cstdio>
 
 Game::Game(): 
   isRunning(false),
   screen(Screen::PLAYING),
-  level(1),
-  score(0),
-  framesForGravity(FPS::FPS),
-  linesCleared(0),
-  frameCount(0),
-  furthestDown(0),
-  timeReset(false),
-  timeResets(0),
-  timer(~0),
-  hold(BlockType::None),
-  holdLocked(false)
+  synced(false),
+  font(nullptr),
+  grid(nullptr),
+  profilePath(nullptr),
+  seed(0),
+  games(0),
+  recordPath(nullptr),
+  watching(false),
+  opponent(Opponent::NONE),
+  transport(nullptr),
+  botNext(0),
+  bot(pool),
+  botPlaying(false),
+  botWait(0),
+  hinting(false),
+  allocationCheck(0),
+  allocationMark{},
+  frames(0),
+  steadyFrom(0),
+  steadyAllocations(0)
  {}
 
 Game::~Game() { clean(); }
 
-constexpr int FACE_OFFSET = TILE_SIZE / 8;
-constexpr int FACE_SIZE = FACE_OFFSET * 2;
-
 int Game::init(const char* title, int x, int y, int w, int h) {
-  srand(time(0));
-  rand();
+  seed = time(0);
 
   if (SDL_Init(SDL_INIT_EVERYTHING) != 0) {
     SDL_Log("SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
@@ -33,7 +39,7 @@ int Game::init(const char* title, int x, int y, int w, int h) {
     return 1;
   }
 
-  window = SDL_CreateWindow(title, x, y, w, h, SDL_WINDOW_SHOWN);
+  window = SDL_CreateWindow(title, x, y, w, h, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
 
   if (!window) {
     SDL_Log("Window creation failed! SDL_Error: %s\n", SDL_GetError());
@@ -42,7 +48,7 @@ int Game::init(const char* title, int x, int y, int w, int h) {
     return 1;
   }
 
-  renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+  renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
   if (!renderer) {
     SDL_Log("Renderer creation failed! SDL_Error: %s\n", SDL_GetError());
     SDL_DestroyWindow(window);
@@ -51,6 +57,10 @@ int Game::init(const char* title, int x, int y, int w, int h) {
     return 1;
   }
 
+  // drivers are free to ignore the vsync request, so ask what we actually got.
+  SDL_RendererInfo info;
+  synced = SDL_GetRendererInfo(renderer, &info) == 0 && (info.flags & SDL_RENDERER_PRESENTVSYNC);
+
   int ttf = TTF_Init();
   if (ttf != 0) {
     SDL_Log("Failed to initialize TrueType Format! SDL_Error: %s\n", SDL_GetError());
@@ -61,8 +71,10 @@ int Game::init(const char* title, int x, int y, int w, int h) {
     return 1;
   }
 
-  font = TTF_OpenFont(Assets::Fonts::FONT, Assets::Fonts::SIZE);
-  if (!font) {
+  SDL_SetWindowMinimumSize(window, COLUMNS * 8, ROWS * 8);
+  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+
+  if (!layout()) {
     SDL_Log("Failed to open font! SDL_Error: %s\n", SDL_GetError());
     SDL_DestroyWindow(window);
     SDL_DestroyRenderer(renderer);
@@ -71,503 +83,574 @@ int Game::init(const char* title, int x, int y, int w, int h) {
     return 1;
   }
 
-  SDL_ShowCursor(SDL_DISABLE);
-  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+  controller.init();
+  inputs.reserve(64);
 
-  for (Color &tileColor : tileColors)
-    tileColor = Colors::empty;
+  SDL_ShowCursor(SDL_DISABLE);
 
-  spawnBlock();
+  newGame();
 
   isRunning = true;
   return 0;
 }
 
-inline constexpr Coords toWindowCoords(int x, int y) {
-  return { x * TILE_SIZE, (Window::HEIGHT - y * TILE_SIZE) - TILE_SIZE };
-}
+bool Game::watch(const char* path) {
+  if (!replay.open(path)) {
+    SDL_Log("Failed to open replay %s\n", path);
+    return false;
+  }
 
-inline constexpr Coords toTileCoords(int x, int y) {
-  return { x / TILE_SIZE, (ROWS - 1) - y / TILE_SIZE };
+  watching = true;
+  replay.seek(engine, cursor, 0);
+  screen = Screen::PLAYING;
+  return true;
 }
 
-void Game::update() {
-  if (screen == Screen::AWAIT_BEGIN) return;
+void Game::setTickRate(int rate) {
+  engine.setTickRate(rate);
+  if (!watching) newGame();
+}
 
-  frameCount++;
+void Game::setSeed(uint64_t value) {
+  seed = value;
+  games = 0;
+  if (!watching && opponent == Opponent::NONE) newGame();
+}
 
-  if (!blockCanDrop() && SDL_GetTicks64() - timer >= 500) {
-    if (timeReset) timeResets++;
+void Game::versusBot(const LinkSettings& settings) {
+  link.configure(settings);
+  opponent = Opponent::LINKED_BOT;
+  transport = &link.end(0);
+  layout();
+  newGame();
+}
 
-    if (!timeReset || timeResets == 4) {
-      if (!place()) {
-        screen = Screen::AWAIT_BEGIN;
-        return;
-      };
+bool Game::versusHost(uint16_t port) {
+  if (!socket.listen(port)) {
+    SDL_Log("Failed to listen on port %d\n", port);
+    return false;
+  }
 
-      spawnBlock();
-      resetTimers();
-    } else timer = SDL_GetTicks64();
+  opponent = Opponent::NETWORK;
+  transport = &socket;
+  layout();
+  newGame();
+  return true;
+}
 
-    timeReset = false;
+bool Game::versusJoin(const char* host, uint16_t port) {
+  if (!socket.connect(host, port)) {
+    SDL_Log("Failed to reach %s:%d\n", host, port);
+    return false;
   }
-  
-  if (frameCount == framesForGravity || framesForGravity == 0) {
-    if (framesForGravity == 0 && level > 30) {
-      for (int i = 0; i < level - 30; i++) moveDown();
-    }
-    else moveDown();
 
-    if (activeBlock.structure.back().y > furthestDown) {
-      furthestDown = activeBlock.structure.back().y;
-      timer = SDL_GetTicks64();
-    }
+  opponent = Opponent::NETWORK;
+  transport = &socket;
+  session.start(seed, 1);
+  layout();
+  newGame();
+  return true;
+}
 
-    frameCount = 0;
-  }
+void Game::send(Input input) {
+  recorder.input(engine, input);
+  engine.input(input);
 }
 
-void Game::render() {
-  SDL_RenderClear(renderer);
+void Game::newGame() {
+  screen = Screen::PLAYING;
+  controller.reset();
 
-  renderBackground();
-  renderShadow();
-  renderBlocks();
-  renderScore();
+  if (watching) {
+    replay.seek(engine, cursor, 0);
+    return;
+  }
 
-  SDL_RenderPresent(renderer);
-}
+  if (opponent != Opponent::NONE) {
+    // a network match plays the seed both ends were given.
+    uint64_t match = opponent == Opponent::LINKED_BOT ? seed + ++games : seed;
+
+    session.start(match, session.side(), engine.getTickRate());
+    botSession.start(match, 1 - session.side(), engine.getTickRate());
+    link.clear();
+    waiting = {};
+    botInputs.clear();
+    botNext = 0;
+    botWait = 0;
+
+    engine = session.match().player(session.side());
+    rival = session.match().player(1 - session.side());
+    return;
+  }
 
-void Game::clean() {
-  SDL_DestroyWindow(window);
-  SDL_DestroyRenderer(renderer);
-  TTF_Quit();
-  SDL_Quit();
+  engine.seed(seed + ++games);
+  engine.reset();
+  rewind.reserve(Rules::REWIND_SECONDS, engine.getTickRate());
+  botWait = 0;
+  recorder.begin(engine, seed + games, Randomizer::Bag);
 }
 
-void Game::renderBackground() {
-  if (screen != Screen::AWAIT_BEGIN) SDL_SetRenderDrawColor(renderer, Colors::empty.r, Colors::empty.g, Colors::empty.b, 255);
-  else SDL_SetRenderDrawColor(renderer, Colors::dead.r, Colors::dead.g, Colors::dead.b, 255);
-  SDL_RenderClear(renderer);
+void Game::endGame() {
+  screen = Screen::AWAIT_BEGIN;
 
-  SDL_SetRenderDrawColor(renderer, 20, 20, 20, 255);
+  if (recordPath && !watching && opponent == Opponent::NONE && !recorder.save(recordPath, engine))
+    SDL_Log("Failed to save replay to %s\n", recordPath);
+}
 
-  // draw horizontal first
-  for (int y = 0; y <= Window::HEIGHT; y += TILE_SIZE)
-    SDL_RenderDrawLine(renderer, 0, y, Window::WIDTH, y);
+void Game::update(uint64_t time) {
+  Profiler::Scope scope(profiler, Profiler::Phase::Update);
 
-  // then vertical
-  for (int x = 0; x <= Window::WIDTH; x += TILE_SIZE)
-    SDL_RenderDrawLine(renderer, x, 0, x, Window::HEIGHT);
-}
+  // a match that looks over can still be taken back by a late input, so versus keeps running on the game over screen.
+  if (opponent != Opponent::NONE) {
+    updateVersus(time);
+    return;
+  }
 
-void Game::renderBlocks() {
-  // begin with set blocks
-  constexpr int faceOffset = TILE_SIZE / 8;
+  if (hinting) hint.update(engine);
 
-  for (int i = 0; i < TOTAL_TILE_COUNT; i++) {
-    Coords tile = toWindowCoords(i % COLUMNS, i / COLUMNS);
-    Color color = tileColors.flat_index(i);
+  if (screen == Screen::AWAIT_BEGIN) return;
 
-    if (color == Colors::empty) continue;
+  if (watching) {
+    if (!replay.step(engine, cursor)) screen = Screen::AWAIT_BEGIN;
+    return;
+  }
 
-    SDL_Rect coloredTile = { tile.x + 1, tile.y + 1, TILE_SIZE - 1, TILE_SIZE - 1 };
-    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, 200);
-    SDL_RenderFillRect(renderer, &coloredTile);
+  if (!botPlaying) {
+    inputs.clear();
+    controller.update(engine, time, inputs);
 
-    SDL_Rect coloredTileFace = { tile.x + faceOffset, tile.y + faceOffset, TILE_SIZE - faceOffset * 2,  TILE_SIZE - faceOffset * 2 };
-    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, 255);
-    SDL_RenderFillRect(renderer, &coloredTileFace);
+    // a tick of play is taken back for every tick the key is down, so the game runs backwards at its own speed.
+    // anything else pressed meanwhile is dropped.
+    if (controller.rewinding()) {
+      if (rewind.pop(engine)) recorder.rewind(engine);
+      return;
+    }
   }
 
-  // then the dropping block
-  for (const Coords& coord : activeBlock.structure) {
-    SDL_Rect coloredTile = { coord.x + 1, coord.y + 1, TILE_SIZE - 1, TILE_SIZE - 1 };
-    SDL_SetRenderDrawColor(renderer, activeBlock.color.r, activeBlock.color.g, activeBlock.color.b, 200);
-    SDL_RenderFillRect(renderer, &coloredTile);
+  rewind.push(engine);
+
+  if (!botPlaying) {
+    for (Input input : inputs)
+      send(input);
+  } else if (--botWait <= 0) {
+    // the controller isn't read while the bot plays, so its buffer holds the bot's inputs instead.
+    bot.decide(engine, inputs);
+    for (Input input : inputs)
+      send(input);
 
-    SDL_Rect coloredTileFace = { coord.x + faceOffset, coord.y + faceOffset, TILE_SIZE - faceOffset * 2,  TILE_SIZE - faceOffset * 2 };
-    SDL_SetRenderDrawColor(renderer, activeBlock.color.r, activeBlock.color.g, activeBlock.color.b, 255);
-    SDL_RenderFillRect(renderer, &coloredTileFace);
+    botWait = engine.toTicks(Controls::BOT_INTERVAL);
   }
+
+  bool alive = engine.tick();
+  recorder.tick(engine);
+
+  if (!alive) endGame();
 }
 
-void Game::renderShadow() {
-  Coords end = endLocation();
-  Coords& ref = activeBlock.structure.back();
+void Game::updateVersus(uint64_t time) {
+  uint64_t frequency = SDL_GetPerformanceFrequency();
+  link.setTime(time / frequency * 1000000 + time % frequency * 1000000 / frequency);
 
-  for (const Coords& coord : activeBlock.structure) {
-    Coords offset = { coord.x - ref.x, coord.y - ref.y };
+  session.poll(*transport);
 
-    SDL_Rect coloredTile = { end.x + offset.x + 1, end.y + offset.y + 1, TILE_SIZE - 1, TILE_SIZE - 1 };
-    SDL_SetRenderDrawColor(renderer, Colors::shadow.r, Colors::shadow.g, Colors::shadow.b, 200);
-    SDL_RenderFillRect(renderer, &coloredTile);
-    
-    SDL_Rect coloredTileFace = { end.x + offset.x + FACE_OFFSET, end.y + offset.y + FACE_OFFSET, TILE_SIZE - FACE_SIZE, TILE_SIZE - FACE_SIZE };
-    SDL_SetRenderDrawColor(renderer, Colors::shadow.r, Colors::shadow.g, Colors::shadow.b, 255);
-    SDL_RenderFillRect(renderer, &coloredTileFace);
+  inputs.clear();
+  controller.update(engine, time, inputs);
+  // a tick holds TickInput::MAX inputs, more than a player can press in one. any past that are dropped.
+  for (Input input : inputs) waiting.add(input);
+
+  // a side that sees the match over waits there, so the other can confirm it (or a late input can undo it).
+  if (!session.match().over() && session.advance(waiting)) waiting = {};
+  session.send(*transport);
+
+  if (opponent == Opponent::LINKED_BOT) {
+    botSession.poll(link.end(1));
+    const Engine& botEngine = botSession.match().player(botSession.side());
+
+    if (botNext == botInputs.size() && --botWait <= 0 && !botSession.match().over()) {
+      bot.decide(botEngine, botInputs);
+      botNext = 0;
+      botWait = engine.toTicks(Controls::BOT_INTERVAL);
+    }
+
+    // one input a tick, sent like any other player's.
+    TickInput input;
+    if (botNext < botInputs.size()) input.add(botInputs[botNext]);
+    if (!botSession.match().over() && botSession.advance(input) && !input.empty()) botNext++;
+    botSession.send(link.end(1));
   }
+
+  engine = session.match().player(session.side());
+  rival = session.match().player(1 - session.side());
+  screen = session.match().over() ? Screen::AWAIT_BEGIN : Screen::PLAYING;
 }
 
-void Game::renderScore() {
-  constexpr SDL_Color white = { 255, 255, 255, 100 };
-  constexpr int pixelsPerChar = 10;
+void Game::render() {
+  // resizes and moves to a screen of different density both change the drawable size.
+  int width, height;
+  if (SDL_GetRendererOutputSize(renderer, &width, &height) == 0 && (width != view.width || height != view.height))
+    layout();
 
-  static SDL_Texture* texture = nullptr;
+  SDL_RenderClear(renderer);
 
-  std::string textString = "Score: " + std::to_string(score) + " | Level: " + std::to_string(level);
-  const char* text = textString.c_str();
-  int text_size = strlen(text);
+  profiler.begin(Profiler::Phase::Background);
+  renderBackground();
+  profiler.end(Profiler::Phase::Background);
 
-  SDL_Surface *surface = TTF_RenderText_Solid(font, text, white);
-  if (texture) SDL_DestroyTexture(texture);
-  texture = SDL_CreateTextureFromSurface(renderer, surface);
-  SDL_FreeSurface(surface);
+  profiler.begin(Profiler::Phase::Shadow);
+  renderShadow();
+  profiler.end(Profiler::Phase::Shadow);
 
-  SDL_Rect rect = { 
-    5,
-    TILE_SIZE / 4, 
-    text_size * pixelsPerChar,
-    TILE_SIZE / 2
-    };
+  profiler.begin(Profiler::Phase::Blocks);
+  renderBlocks();
+  profiler.end(Profiler::Phase::Blocks);
 
-  SDL_RenderCopy(renderer, texture, NULL, &rect);
-}
+  profiler.begin(Profiler::Phase::Score);
+  renderScore();
+  profiler.end(Profiler::Phase::Score);
 
-bool Game::blockCanDrop() {
-  auto it = std::find_if(activeBlock.structure.begin(), activeBlock.structure.end(), [this](const Coords& coord) {
-    if (coord.y + TILE_SIZE >= Window::HEIGHT) return true;
-    if (coord.y + TILE_SIZE < 0) return false;
+  renderProfile();
 
-    Coords tileCoords = toTileCoords(coord.x, coord.y);
+  profiler.begin(Profiler::Phase::Present);
+  SDL_RenderPresent(renderer);
+  profiler.end(Profiler::Phase::Present);
 
-    if (tileColors[tileCoords.y - 1][tileCoords.x] != Colors::empty) return true;
+  // with vsync on, presenting blocks until the frame is handed to the display, so this is close to when it shows.
+  controller.presented(SDL_GetPerformanceCounter());
+  profiler.endFrame();
 
-    return false;
-  });
+  if (allocationCheck > 0) countAllocations();
+}
 
-  if (it != activeBlock.structure.end()) return false;
-  else return true;
+void Game::quit() {
+  if (screen == Screen::PLAYING) endGame();
+  if (profilePath && !profiler.save(profilePath))
+    SDL_Log("Failed to save profile to %s\n", profilePath);
+  isRunning = false;
 }
 
-bool Game::moveDown() {
-  if (!blockCanDrop()) return false;
+void Game::countAllocations() {
+  Allocations::Count total = Allocations::thisThread();
+  Allocations::Count frame = total - allocationMark;
+  allocationMark = total;
 
-  for (Coords& coord : activeBlock.structure)
-    coord.y += TILE_SIZE;
+  if (++frames > steadyFrom && frame.allocations > 0) {
+    steadyAllocations++;
+    SDL_Log("Frame %d allocated %llu times, %llu bytes\n", frames, (unsigned long long)frame.allocations,
+      (unsigned long long)frame.bytes);
+  }
 
-  return true;
+  if (frames >= allocationCheck) {
+    SDL_Log("%d of %d steady frames allocated\n", steadyAllocations, std::max(frames - steadyFrom, 0));
+    quit();
+  }
 }
 
-bool Game::moveHorizontal(int direction) {
-  auto it = std::find_if(activeBlock.structure.begin(), activeBlock.structure.end(), [this, &direction](const Coords& coord) {
-    int sum = coord.x + direction * TILE_SIZE;
-    if (sum < 0 || sum >= Window::WIDTH) return true;
+void Game::clean() {
+  if (grid) SDL_DestroyTexture(grid);
+  grid = nullptr;
+  glyphs.destroy();
+  if (font) TTF_CloseFont(font);
+  font = nullptr;
+
+  SDL_DestroyWindow(window);
+  SDL_DestroyRenderer(renderer);
+  TTF_Quit();
+  SDL_Quit();
+}
 
-    if (coord.y < 0) return false;
+bool Game::layout() {
+  int width = Window::WIDTH, height = Window::HEIGHT;
+  SDL_GetRendererOutputSize(renderer, &width, &height);
 
-    Coords tileCoords = toTileCoords(coord.x, coord.y);
+  int tileSize = view.tileSize;
+  // versus splits the window between the two boards.
+  view = View::fit(opponent != Opponent::NONE ? width / 2 : width, height);
+  rivalView = view;
+  rivalView.left += width / 2;
+  view.width = rivalView.width = width;
+  tiles.resize(view.tileSize);
 
-    if (tileColors[tileCoords.y][tileCoords.x + direction] != Colors::empty) return true;
+  if (!font || view.tileSize != tileSize) {
+    TTF_Font* resized = TTF_OpenFont(Assets::Fonts::FONT, std::max(1, int(view.tileSize * Assets::Fonts::SIZE)));
+    if (!resized) return false;
 
-    return false;
-  });
+    if (font) TTF_CloseFont(font);
+    font = resized;
 
-  if (it != activeBlock.structure.end()) return false;
+    if (!glyphs.build(renderer, font))
+      SDL_Log("Failed to build the glyph atlas! SDL_Error: %s\n", SDL_GetError());
+  }
 
-  for (Coords& coord : activeBlock.structure)
-    coord.x += direction * TILE_SIZE;
+  for (Label& label : hud) label.refresh(glyphs);
+  for (Label& label : profileLines) label.refresh(glyphs);
 
-  timeReset = true;
+  bakeGrid();
+  warmUp();
   return true;
 }
 
-bool Game::rotate(int direction) {
-  if (activeBlock.type == BlockType::O) return false;
+void Game::bakeGrid() {
+  if (grid) SDL_DestroyTexture(grid);
 
-  int newRotationState = activeBlock.rotationState + direction;
-  if (activeBlock.rotationState == 3) newRotationState = 0;
-  else if (activeBlock.rotationState == 0) newRotationState = 3;
+  grid = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, view.boardWidth() + 1, view.boardHeight() + 1);
+  if (!grid) return;
 
-  std::array<std::pair<int, int>, 5> testCases = 
-  activeBlock.type == BlockType::I 
-    ? kickMapI.find({ activeBlock.rotationState, newRotationState })->second
-    : kickMap.find({ activeBlock.rotationState, newRotationState })->second;
+  SDL_SetTextureBlendMode(grid, SDL_BLENDMODE_BLEND);
+  SDL_SetRenderTarget(renderer, grid);
 
-  Coords point = activeBlock.structure.back();
+  SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+  SDL_RenderClear(renderer);
+  drawGrid(0, 0);
 
-  static std::array<Coords, 4> tempStructure;
-  
-  for (std::pair<int, int> vector : testCases) {
-    for (int i = 0; i < activeBlock.structure.size(); i++) {
-      const Coords& coord = activeBlock.structure[i];
+  SDL_SetRenderTarget(renderer, nullptr);
+}
 
-      Coords relativePos = { coord.x - point.x, coord.y - point.y };
-      Coords newRelativePos = { -direction * relativePos.y + vector.first * TILE_SIZE, direction * relativePos.x + vector.second * TILE_SIZE };
+void Game::drawGrid(int left, int top) {
+  SDL_SetRenderDrawColor(renderer, 20, 20, 20, 255);
+  int right = left + view.boardWidth(), bottom = top + view.boardHeight();
 
-      tempStructure[i] = { point.x + newRelativePos.x, point.y + newRelativePos.y };
-    }
+  // draw horizontal first
+  for (int y = top; y <= bottom; y += view.tileSize)
+    SDL_RenderDrawLine(renderer, left, y, right, y);
 
-    // validate rotation
-    bool bad = false;
-    for (const Coords& coord : tempStructure) {
-      if (coord.x < 0 || coord.x >= Window::WIDTH || coord.y > Window::HEIGHT) {
-        bad = true;
-        break;
-      }
+  // then vertical
+  for (int x = left; x <= right; x += view.tileSize)
+    SDL_RenderDrawLine(renderer, x, top, x, bottom);
+}
+
+void Game::renderBackground() {
+  if (screen != Screen::AWAIT_BEGIN) SDL_SetRenderDrawColor(renderer, Colors::empty.r, Colors::empty.g, Colors::empty.b, 255);
+  else SDL_SetRenderDrawColor(renderer, Colors::dead.r, Colors::dead.g, Colors::dead.b, 255);
+  SDL_RenderClear(renderer);
 
-      if (coord.y > 0) {
-        Coords tileCoords = toTileCoords(coord.x, coord.y);
+  // the grid only changes with the window size, so it is drawn into a texture then. renderers without render targets draw it every frame.
+  if (grid) {
+    SDL_Rect area = { view.left, view.top, view.boardWidth() + 1, view.boardHeight() + 1 };
+    SDL_RenderCopy(renderer, grid, NULL, &area);
 
-        if (tileColors[tileCoords.y][tileCoords.x] != Colors::empty) {
-          bad = true;
-          break;
-        }
-      }
+    if (opponent != Opponent::NONE) {
+      area.x = rivalView.left;
+      SDL_RenderCopy(renderer, grid, NULL, &area);
     }
+  } else {
+    drawGrid(view.left, view.top);
+    if (opponent != Opponent::NONE) drawGrid(rivalView.left, rivalView.top);
+  }
+}
+
+void Game::renderBlocks() {
+  addBlocks(engine, view);
+  tiles.flush(renderer);
 
-    if (bad) continue;
+  if (opponent == Opponent::NONE) return;
 
-    activeBlock.structure = tempStructure;
-    break;
+  addBlocks(rival, rivalView);
+  tiles.flush(renderer);
+}
+
+void Game::addBlocks(const Engine& shown, const View& at) {
+  // begin with set blocks
+  // only the visible rows, which come first.
+  const Board::CellGrid& cells = shown.getBoard().cells();
+
+  for (int i = 0; i < TOTAL_TILE_COUNT; i++) {
+    Board::Cell cell = cells.flat_index(i);
+    if (cell == Board::EMPTY) continue;
+
+    SDL_Point tile = at.tile(i % COLUMNS, i / COLUMNS);
+    tiles.add(tile.x, tile.y, Pieces::COLORS[cell]);
   }
 
-  activeBlock.rotationState = newRotationState;
-  timeReset = true;
+  // then the dropping block. rows above the field are off the board, so they aren't drawn.
+  const Block& activeBlock = shown.block();
+  for (const Coords& cell : Pieces::cells(activeBlock)) {
+    if (cell.y >= ROWS) continue;
 
-  return true;
+    SDL_Point tile = at.tile(cell.x, cell.y);
+    tiles.add(tile.x, tile.y, Pieces::COLORS[activeBlock.type]);
+  }
+}
+
+void Game::renderShadow() {
+  // the first block of the hint can sit where the ghost is, so it goes in a batch of its own, underneath.
+  if (hinting && opponent == Opponent::NONE) {
+    addHint(view);
+    tiles.flush(renderer);
+  }
+
+  addShadow(engine, view);
+  if (opponent != Opponent::NONE) addShadow(rival, rivalView);
+  tiles.flush(renderer);
 }
 
-Coords Game::endLocation() {
-  auto copy = activeBlock.structure;
+void Game::addShadow(const Engine& shown, const View& at) {
+  Coords end = shown.endLocation();
+  const Block& activeBlock = shown.block();
 
-  while (moveDown());
-  Coords coord = activeBlock.structure.back();
-  activeBlock.structure = copy;
+  for (const Coords& cell : Pieces::cells(activeBlock, end.x - activeBlock.x, end.y - activeBlock.y)) {
+    if (cell.y >= ROWS) continue;
 
-  return coord;
+    SDL_Point tile = at.tile(cell.x, cell.y);
+    tiles.add(tile.x, tile.y, Colors::shadow);
+  }
 }
 
-bool Game::place() {
-  for (const Coords& coord : activeBlock.structure) {
-    if (coord.y < 0 - TILE_SIZE) return false;
+void Game::addHint(const View& at) {
+  for (const PerfectClear::Step& step : hint.steps()) {
+    for (const Coords& cell : step.cells) {
+      if (cell.y >= ROWS) continue;
 
-    Coords tileCoords = toTileCoords(coord.x, coord.y);
-    tileColors[tileCoords.y][tileCoords.x] = activeBlock.color;
+      SDL_Point tile = at.tile(cell.x, cell.y);
+      tiles.add(tile.x, tile.y, Colors::hint);
+    }
   }
+}
 
-  // clear lines
+void Game::renderScore() {
+  constexpr SDL_Color white = { 255, 255, 255, 200 };
+  constexpr char names[] = " IOTLJSZ";
 
-  int cleared = 0;
+  char text[Label::MAX_LENGTH + 1];
+  int left = view.left + 5, top = view.top + view.tileSize / 4;
+  int lineHeight = glyphs.getLineHeight();
 
-  for (int row = ROWS - 1; row >= 0; row--) {
-    bool clear = true;
-    for (int col = 0; col < COLUMNS; col++)
-      if (tileColors[row][col] == Colors::empty) {
-        clear = false;
-        break;
-      }
+  snprintf(text, sizeof(text), "Score: %d | Level: %d", engine.getScore(), engine.getLevel());
+  hud[0].set(glyphs, text, left, top, white);
 
-    if (clear) {
-      for (int col = 0; col < COLUMNS; col++)
-        tileColors[row][col] = Colors::empty;
+  snprintf(text, sizeof(text), "Lines: %d | Pieces: %d", engine.getLinesCleared(), engine.getPieces());
+  hud[1].set(glyphs, text, left, top + lineHeight, white);
 
-      for (int r = row + 1; r < ROWS; r++) {
-        for (int c = 0; c < COLUMNS; c++) {
-          tileColors[r - 1][c] = tileColors[r][c];
-        }
-      }
+  char next[Rules::PREVIEW + 1];
+  for (int i = 0; i < Rules::PREVIEW; i++) next[i] = names[engine.getNext(i)];
+  next[Rules::PREVIEW] = '\0';
 
-      cleared++;
-      linesCleared++;
-    }
-  }
+  snprintf(text, sizeof(text), "Hold: %c | Next: %s", names[engine.getHold()], next);
+  hud[2].set(glyphs, text, left, top + lineHeight * 2, white);
 
-  switch (cleared) {
-    case 1: score += 100; break;
-    case 2: score += 300; break;
-    case 3: score += 500; break;
-    case 4: score += 800; break;
-    default: break;
-  }
+  snprintf(text, sizeof(text), "Latency: %.1f ms | Worst: %.1f ms", controller.averageLatency(), controller.worstLatency());
+  hud[3].set(glyphs, text, left, top + lineHeight * 3, white);
 
-  int levelBefore = level;
-  level = linesCleared / 5 + 1;
-  if (level != levelBefore)
-    framesForGravity = framesForGravity * (1.0f - 0.1f);
+  if (opponent != Opponent::NONE) {
+    const Rollback::Stats& stats = session.stats();
+    snprintf(text, sizeof(text), "Garbage: %d | Rollback: worst %d | Stalls: %llu%s", engine.getPendingGarbage(),
+      stats.worst, (unsigned long long)stats.stalls, stats.desyncs ? " | DESYNC" : "");
+    hud[4].set(glyphs, text, left, top + lineHeight * 4, white);
+  }
 
-  frameCount = 0;
-  holdLocked = false;
-  return true;
+  for (const Label& label : hud)
+    label.draw(renderer, glyphs);
 }
 
-void Game::spawnBlock(BlockType type) {
-  // crazy rng algorithm
-  if (type != BlockType::None) activeBlock.type = type;
-  else {
-    static BlockType lastBlock = BlockType::None;
-    BlockType blockType = static_cast<BlockType>(rand() % 7);
-    if (blockType == lastBlock) blockType = static_cast<BlockType>(rand() % 7);
-    lastBlock = blockType;
+void Game::renderProfile() {
+  if (!profiler.enabled()) return;
 
-    activeBlock.type = blockType;
-  }
+  constexpr SDL_Color gray = { 200, 200, 200, 230 };
+  int lineHeight = glyphs.getLineHeight();
+  int margin = view.tileSize / 4;
+  // a heading, the phases, then allocations in builds that count them.
+  constexpr int lines = Profiler::PHASES + 1 + Allocations::TRACKED;
+  int left = view.left + 5, top = view.top + view.boardHeight() - lines * lineHeight - margin;
 
-  int height = 0;
-  for (int i = tileColors.size() - 1; i >= 0; i--) {
-    if (tileColors.flat_index(i) != Colors::empty) {
-      height = i / COLUMNS;
-      break;
-    }
-  }
+  SDL_Rect panel = { view.left, top, view.boardWidth(), lines * lineHeight + margin };
+  SDL_SetRenderDrawColor(renderer, 0, 0, 0, 160);
+  SDL_RenderFillRect(renderer, &panel);
+
+  char text[Label::MAX_LENGTH + 1];
+  snprintf(text, sizeof(text), "ms over %d frames: p50 p95 p99 max", profiler.frames());
+  profileLines[0].set(glyphs, text, left, top, gray);
 
-  int heightOffset = 0;
-  if (height != tileColors.size()) {
-    if (height >= ROWS - 1) heightOffset = 3;
-    else if (height >= ROWS - 4) heightOffset = 1;
+  for (int i = 0; i < Profiler::PHASES; i++) {
+    Profiler::Phase phase = Profiler::Phase(i);
+    Profiler::Summary summary = profiler.summary(phase);
+
+    snprintf(text, sizeof(text), "%-10s %6.2f %6.2f %6.2f %6.2f", Profiler::name(phase), summary.p50, summary.p95, summary.p99, summary.max);
+    profileLines[i + 1].set(glyphs, text, left, top + lineHeight * (i + 1), gray);
   }
 
-  Coords refTile = toWindowCoords(COLUMNS / 2 - 1, ROWS - 2 + heightOffset);
-
-  // THE LAST VALUE IS THE POINT IN WHICH THE BLOCK ROTATES AROUND
-  
-  switch (activeBlock.type) {
-    case BlockType::I:
-      activeBlock.structure = { refTile.moveX(-1), refTile.moveX(1), refTile.moveX(2), refTile };
-      activeBlock.color = Colors::lightBlue;
-      break;
-    case BlockType::O:
-      activeBlock.structure = { refTile.moveY(1), refTile.move(1, 1), refTile.moveX(1), refTile };
-      activeBlock.color = Colors::yellow;
-      break;
-    case BlockType::T:
-      activeBlock.structure = { refTile.moveX(-1), refTile.moveX(1), refTile.moveY(1), refTile };
-      activeBlock.color = Colors::violet;
-      break;
-    case BlockType::L:
-      activeBlock.structure = { refTile, refTile.moveX(2), refTile.move(2, 1), refTile.moveX(1) };
-      activeBlock.color = Colors::orange;
-      break;
-    case BlockType::J:
-      activeBlock.structure = { refTile.moveY(1), refTile, refTile.moveX(2), refTile.moveX(1) };
-      activeBlock.color = Colors::red;
-      break;
-    case BlockType::S:
-      activeBlock.structure = { refTile.moveY(1), refTile.move(1, 1), refTile.moveX(2), refTile.moveX(1) };
-      activeBlock.color = Colors::green;
-      break;
-    case BlockType::Z:
-      activeBlock.structure = { refTile.move(2, 1), refTile.move(1, 1), refTile, refTile.moveX(1) };
-      activeBlock.color = Colors::darkBlue;
-      break;
-    case BlockType::None:
-      break;
+  if (Allocations::TRACKED) {
+    Profiler::Summary summary = profiler.allocationSummary();
+    snprintf(text, sizeof(text), "%-10s %6.0f %6.0f %6.0f %6.0f", "allocs", summary.p50, summary.p95, summary.p99, summary.max);
+    profileLines[Profiler::PHASES + 1].set(glyphs, text, left, top + lineHeight * (Profiler::PHASES + 1), gray);
   }
+
+  for (const Label& label : profileLines)
+    label.draw(renderer, glyphs);
 }
 
 void Game::handleEvents() {
+  Profiler::Scope scope(profiler, Profiler::Phase::Events);
   SDL_Event event;
 
   while (SDL_PollEvent(&event)) {
     switch (event.type) {
+      case SDL_RENDER_TARGETS_RESET:
+        bakeGrid();
+        glyphs.build(renderer, font);
+        for (Label& label : hud) label.refresh(glyphs);
+        for (Label& label : profileLines) label.refresh(glyphs);
+        break;
       case SDL_QUIT:
-        isRunning = false;
+        quit();
         return;
       case SDL_KEYDOWN:
-        if (screen == Screen::AWAIT_BEGIN && event.key.keysym.sym == SDLK_SPACE) {
-          screen = Screen::PLAYING;
-          level = 1;
-          score = 0;
-          framesForGravity = FPS::FPS;
-          linesCleared = 0;
-          frameCount = 0;
-          resetTimers();
-          hold = BlockType::None;
-          holdLocked = false;
-
-          for (Color &tileColor : tileColors)
-            tileColor = Colors::empty;
-
-          spawnBlock();
-
-          return;
-        } else if (screen == Screen::AWAIT_BEGIN) return;
-
-        switch (event.key.keysym.sym) {
-          case SDLK_SPACE:
-            while (moveDown());
-            if (!place()) {
-              screen = Screen::AWAIT_BEGIN;
-              return;
-            }
-
-            resetTimers();
-            spawnBlock();
-            
-            break;
-          case SDLK_UP:
-            rotate(1);
-            break;
-          case SDLK_z:
-            rotate(-1);
-            break;
-          case SDLK_c:
-            if (holdLocked) break;
-
-            if (hold != BlockType::None) {
-              BlockType before = activeBlock.type;
-              spawnBlock(hold);
-              hold = before;
-            } else {
-              hold = activeBlock.type;
-              spawnBlock();
-            }
-
-            holdLocked = true;
-            break;
+        if (event.key.keysym.sym == SDLK_F3) {
+          profiler.setEnabled(!profiler.enabled());
+          break;
         }
-    }
-  }
 
-  if (screen == Screen::AWAIT_BEGIN) return;
+        if (event.key.keysym.sym == SDLK_h && opponent == Opponent::NONE) {
+          hinting = !hinting;
+          warmUp();
+          break;
+        }
 
-  static int downWait = 0;
-  static int leftWait = 0;
-  static int rightWait = 0;
-  constexpr int delay = FPS::FPS / 15;
-  constexpr int beforeContinuous = FPS::FPS / 10;
-  
-  enum Lock {
-    Left, Right, None
-  };
-
-  // lock is used to handle movement when both left and right move keys are pressed.
-  // The one pressed last has priority. 
-  static Lock lock = Lock::None;
-
-  const Uint8* keystate = SDL_GetKeyboardState(NULL);
-
-  if (keystate[SDL_SCANCODE_DOWN]) {
-    if (downWait % delay == 0) {
-      if (moveDown()) frameCount = 0;
-    }
+        if (watching) {
+          uint64_t jump = Replays::KEYFRAME_INTERVAL * replay.header().tickRate;
+
+          switch (event.key.keysym.sym) {
+            case SDLK_SPACE:
+              newGame();
+              break;
+            case SDLK_LEFT:
+              replay.seek(engine, cursor, engine.getTicks() > jump ? engine.getTicks() - jump : 0);
+              screen = Screen::PLAYING;
+              break;
+            case SDLK_RIGHT:
+              replay.seek(engine, cursor, std::min(engine.getTicks() + jump, replay.length()));
+              break;
+          }
+
+          break;
+        }
 
-    downWait++;
-  } else downWait = 0;
+        if (screen == Screen::AWAIT_BEGIN) {
+          // a match over the network can't be restarted from one end, and one against the bot only once it's settled.
+          bool restartable = opponent == Opponent::NONE || (opponent == Opponent::LINKED_BOT && session.settled());
+          if (event.key.keysym.sym == SDLK_SPACE && restartable) newGame();
 
-  if (keystate[SDL_SCANCODE_LEFT]) {
-    if ((lock != Lock::Right || !keystate[SDL_SCANCODE_RIGHT]) && (leftWait == 0 || (leftWait > beforeContinuous && leftWait % delay == 0)))
-      moveHorizontal(-1);
+          // rewinding out of a lost game carries on with it, by hand even if the bot was playing.
+          if (event.key.keysym.scancode == SDL_SCANCODE_R && opponent == Opponent::NONE && rewind.size() > 0) {
+            screen = Screen::PLAYING;
+            botPlaying = false;
+            controller.reset();
+            controller.handle(event.key);
+          }
 
-    leftWait++;
-    if (lock != Lock::Left || !keystate[SDL_SCANCODE_RIGHT]) lock = Lock::Right;
-  } else leftWait = 0;
-  
-  if (keystate[SDL_SCANCODE_RIGHT]) {
-    if ((lock != Lock::Left || !keystate[SDL_SCANCODE_LEFT]) && (rightWait == 0 || (rightWait > beforeContinuous && rightWait % delay == 0)))
-      moveHorizontal(1);
+          break;
+        }
+
+        if (event.key.keysym.sym == SDLK_b && opponent == Opponent::NONE) {
+          botPlaying = !botPlaying;
+          controller.reset();
+          warmUp();
+          break;
+        }
 
-    rightWait++;
-    if (lock != Lock::Right || !keystate[SDL_SCANCODE_LEFT]) lock = Lock::Left;
-  } else rightWait = 0;
+        if (!botPlaying) controller.handle(event.key);
+        break;
+      case SDL_KEYUP:
+        if (screen == Screen::PLAYING && !botPlaying && !watching) controller.handle(event.key);
+        break;
+    }
+  }
 }
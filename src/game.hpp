@@ -3,102 +3,174 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 #include "constants.hpp"
-#include "array.hpp"
-#include <vector>
+#include "tile_batch.hpp"
+#include "view.hpp"
+#include "text.hpp"
+#include "controller.hpp"
+#include "profiler.hpp"
+#include "allocations.hpp"
+#include "hint.hpp"
+#include "engine/engine.hpp"
+#include "engine/bot.hpp"
+#include "engine/replay.hpp"
+#include "engine/rewind.hpp"
+#include "engine/rollback.hpp"
+#include "engine/transport.hpp"
 
 enum Screen {
   AWAIT_BEGIN,
   PLAYING
 };
 
-enum BlockType {
-  None, I, O, T, L, J, S, Z
-};
-
-struct Coords {
-  int x, y;
-
-  // move functions automatically convert tile coords to window coords.
-  inline Coords move(int x, int y) const {
-    return { this->x + x * TILE_SIZE, this->y - y * TILE_SIZE };
-  }
-
-  inline Coords moveX(int x) const {
-    return { this->x + x * TILE_SIZE, this->y };
-  }
-
-  inline Coords moveY(int y) const {
-    return { this->x, this->y - y * TILE_SIZE };
-  }
-};
-
-struct Block {
-  std::array<Coords, 4> structure;
-  Color color;
-  BlockType type;
-
-  // amount of times rotated clockwise
-  int rotationState = 0;
+// who the other board belongs to, if there is one.
+enum Opponent {
+  NONE,
+  // the bot, on the far end of a simulated link.
+  LINKED_BOT,
+  // another copy of the game, over UDP.
+  NETWORK
 };
 
+// SDL front-end: turns keyboard state into engine inputs and draws whatever the engine holds.
 class Game {
 public:
   Game();
   ~Game();
 
   int init(const char* title, int x, int y, int w, int h);
+  // saves every game to path when it ends or the window closes.
+  inline void record(const char* path) { recordPath = path; }
+  // turns the profiler on from the start and writes its frames to path as CSV on exit.
+  inline void profileTo(const char* path) { profilePath = path; profiler.setEnabled(true); }
+  // quits after the given number of frames, logging every frame past the warm-up (see Allocations) that allocated.
+  // only builds made with TRACK_ALLOCATIONS=1 can tell.
+  inline void checkAllocations(int frames) { allocationCheck = frames; }
+  inline bool allocatedWhenSteady() const { return steadyAllocations > 0; }
+  // plays a replay file instead of taking input. left and right jump ten seconds, space starts over.
+  bool watch(const char* path);
+  // simulation steps per second. starts a new game so the recording holds one rate throughout.
+  void setTickRate(int rate);
+  // games are seeded counting up from value. a network match uses value itself, so both ends must pass the same one.
+  // starts a new game, like setTickRate(), since the first one was dealt before any options were read.
+  void setSeed(uint64_t value);
+  // a versus match against the bot, each side running rollback over a link with the given latency, jitter and loss.
+  void versusBot(const LinkSettings& settings);
+  // a versus match over UDP, as the listening side (player one) or the connecting one (player two).
+  // one match per run: once it is over, both sides have to start again.
+  bool versusHost(uint16_t port);
+  bool versusJoin(const char* host, uint16_t port);
   void handleEvents();
+  // ends the game in progress and writes the profile, as closing the window does.
+  void quit();
   void clean();
 
-  void update();
+  // runs one tick, simulating up to time (an SDL_GetPerformanceCounter value). key events queued by handleEvents
+  // act on the tick their timestamp falls in.
+  void update(uint64_t time);
   void render();
 
   void renderBackground();
   void renderBlocks();
   void renderShadow();
+  // one board's tiles into the batch, at view.
+  void addBlocks(const Engine& shown, const View& at);
+  void addShadow(const Engine& shown, const View& at);
+  // the perfect clear the hint found, every block of it at once.
+  void addHint(const View& at);
   void renderScore();
-  
-  bool blockCanDrop();
-  bool moveDown();
-  // 1 = right, -1 = left
-  bool moveHorizontal(int direction);
-  // 1 = clockwise, -1 = counterclockwise
-  bool rotate(int direction);
-
-  Coords endLocation();
-
-  bool place();
-
-  void spawnBlock(BlockType type = BlockType::None);
+  // phase timings, while F3 has the profiler on.
+  void renderProfile();
+
+  // fits the board to the window's current drawable size, rasterising text and the grid again to match.
+  bool layout();
+  void bakeGrid();
+  // x and y are where the board's top left corner goes.
+  void drawGrid(int x, int y);
+
+  // every input goes through here, so it ends up in the recording.
+  void send(Input input);
+  void newGame();
+  void endGame();
+  // one tick of a versus match: the local inputs go to the rollback session, and the bot takes its turn if it plays.
+  void updateVersus(uint64_t time);
+  // buffers grow to fit whatever runs next, so the allocation check gives the loop a while to settle again.
+  inline void warmUp() { steadyFrom = frames + Allocations::WARMUP_FRAMES; }
+  void countAllocations();
 
   inline bool running() const { return isRunning; };
   inline bool getScreen() const { return screen; }
+  inline int tickRate() const { return engine.getTickRate(); }
+  // whether presenting a frame waits for the display, so the main loop needn't cap the frame rate itself.
+  inline bool vsync() const { return synced; }
 private:
   bool isRunning;
   Screen screen;
   SDL_Window *window;
   SDL_Renderer *renderer;
+  bool synced;
   TTF_Font *font;
-
-  Block activeBlock;
-  array2d<Color, COLUMNS, ROWS> tileColors;
-  int level;
-  int score;
-  int framesForGravity;
-  int linesCleared;
-
-  int frameCount;
-  int furthestDown;
-  bool timeReset;
-  int timeResets;
-  uint64_t timer;
-  inline void resetTimers() {
-    furthestDown = 0;
-    timeReset = false;
-    timeResets = 0;
-    timer = ~0;
-  };
-
-  BlockType hold;
-  bool holdLocked;
-};
\ No newline at end of file
+  SDL_Texture *grid;
+  TileBatch tiles;
+  View view;
+
+  GlyphAtlas glyphs;
+  // score and level, lines and pieces, hold and the preview, then input latency, then rollback figures in versus.
+  std::array<Label, 5> hud;
+
+  Profiler profiler;
+  const char* profilePath;
+  // a heading, then a line per phase and one for allocations.
+  std::array<Label, Profiler::PHASES + 2> profileLines;
+
+  Engine engine;
+  uint64_t seed;
+  // games dealt since the seed was set. solo games and bot matches play seed + games, so however many were started
+  // before the options were all in, a network match still gets the seed itself.
+  uint64_t games;
+
+  Controller controller;
+  // inputs due this tick. kept around so steady play doesn't allocate.
+  std::vector<Input> inputs;
+
+  // every tick of the last Rules::REWIND_SECONDS, taken back one per tick while R is held, even after the game ends.
+  Rewind rewind;
+
+  ReplayRecorder recorder;
+  const char* recordPath;
+  Replay replay;
+  Replay::Cursor cursor;
+  bool watching;
+
+  // in versus the engine above is a copy of this side's player, taken after every tick, and rival is the other one.
+  Opponent opponent;
+  Rollback session;
+  Engine rival;
+  View rivalView;
+  Transport* transport;
+  UdpTransport socket;
+  SimulatedLink link;
+  // the bot's own session at the far end of the link, and the inputs it has decided on but not sent.
+  Rollback botSession;
+  std::vector<Input> botInputs;
+  size_t botNext;
+  // inputs held back while the session waits for the other side to catch up.
+  TickInput waiting;
+
+  // toggled with B. while on, the bot places a block every Controls::BOT_INTERVAL and the movement keys are ignored.
+  TaskPool pool;
+  Bot bot;
+  bool botPlaying;
+  int botWait;
+
+  // toggled with H outside versus. while on, a perfect clear for the blocks in sight is looked for every time one
+  // spawns, and drawn under the ghost once found.
+  Hint hint;
+  bool hinting;
+
+  // see checkAllocations(). frames counts every frame drawn, and only those after steadyFrom have to go without.
+  int allocationCheck;
+  Allocations::Count allocationMark;
+  int frames;
+  int steadyFrom;
+  int steadyAllocations;
+};
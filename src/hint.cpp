@@ -0,0 +1,85 @@
+#include "hint.hpp"
+#include <algorithm>
+
+Hint::Hint():
+  pool(std::max(2u, std::thread::hardware_concurrency()) - 1),
+  solver(pool),
+  wantedKey(~0ull),
+  pending(false),
+  foundKey(~0ull),
+  ready(false),
+  quitting(false),
+  shownKey(~0ull),
+  thread(&Hint::loop, this)
+{
+  // a line is at most every block known, so showing one never has to grow this.
+  shown.reserve(Rules::PREVIEW + 2);
+}
+
+Hint::~Hint() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    quitting = true;
+    solver.cancel();
+  }
+
+  wake.notify_one();
+  thread.join();
+}
+
+uint64_t Hint::keyOf(const Engine& engine) {
+  return engine.getBoard().hash() ^ Zobrist::HOLD[engine.getHold()] ^ Zobrist::mix(engine.getPieces());
+}
+
+void Hint::update(const Engine& engine) {
+  uint64_t key = keyOf(engine);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (key != wantedKey) {
+      wanted = engine;
+      wantedKey = key;
+      pending = true;
+      solver.cancel();
+      wake.notify_one();
+    }
+
+    if (ready && foundKey == key) {
+      // both keep their capacity, so once they have grown to a full line this doesn't allocate.
+      shown.assign(found.begin(), found.end());
+      shownKey = key;
+      ready = false;
+    }
+  }
+
+  if (shownKey != key) shown.clear();
+}
+
+void Hint::loop() {
+  std::vector<PerfectClear::Step> steps;
+  std::unique_lock<std::mutex> lock(mutex);
+
+  while (true) {
+    wake.wait(lock, [&] { return pending || quitting; });
+    if (quitting) return;
+
+    // update() cancels under the lock too, so a newer position turning up any time after this calls the search off.
+    Engine position = wanted;
+    uint64_t key = wantedKey;
+    uint32_t ticket = solver.ticket();
+    pending = false;
+
+    lock.unlock();
+    solver.solve(position, steps, ticket);
+    lock.lock();
+
+    // a search called off for a newer position is dropped. one that found nothing still reports, so the last line
+    // shown goes away.
+    if (key != wantedKey) continue;
+
+    found.assign(steps.begin(), steps.end());
+    foundKey = key;
+    ready = true;
+  }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "engine/engine.hpp"
+#include "engine/perfect_clear.hpp"
+#include "engine/task_pool.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// looks for perfect clears on a thread of its own, with a task pool that leaves a core for the game, so a frame
+// never waits on a search. a new search starts whenever the position changes (a block spawning or being held),
+// calling off the one before.
+class Hint {
+public:
+  Hint();
+  ~Hint();
+
+  Hint(const Hint&) = delete;
+  Hint& operator=(const Hint&) = delete;
+
+  // searches engine's position unless it is the one searched last, and picks up whatever search has finished.
+  void update(const Engine& engine);
+  // the clear found for the position last passed to update(). empty while the search is running or found nothing.
+  inline const std::vector<PerfectClear::Step>& steps() const { return shown; }
+private:
+  // what tells positions apart for the hint: the stack, hold, and how far into the sequence the game is.
+  static uint64_t keyOf(const Engine& engine);
+  void loop();
+
+  TaskPool pool;
+  PerfectClear solver;
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  // the position wanted, handed over by update().
+  Engine wanted;
+  uint64_t wantedKey;
+  bool pending;
+  // the last search's result, waiting to be picked up.
+  std::vector<PerfectClear::Step> found;
+  uint64_t foundKey;
+  bool ready;
+  bool quitting;
+
+  // only touched by the game's thread.
+  std::vector<PerfectClear::Step> shown;
+  uint64_t shownKey;
+
+  // started last, once everything it uses is set up.
+  std::thread thread;
+};
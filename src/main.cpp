@@ -1,31 +1,94 @@
 #include <SDL2/SDL.h>
 #include "game.hpp"
+#include <algorithm>
 #include <iostream>
+#include <cstring>
+#include <string>
+
+// sleeps through most of the wait, then spins the last millisecond or so, since SDL_Delay can overshoot by that much.
+static void waitUntil(uint64_t deadline, uint64_t frequency) {
+  uint64_t now = SDL_GetPerformanceCounter();
+  if (now >= deadline) return;
+
+  uint64_t milliseconds = (deadline - now) * 1000 / frequency;
+  if (milliseconds > 1) SDL_Delay(milliseconds - 1);
+
+  while (SDL_GetPerformanceCounter() < deadline);
+}
+
+// usage: main [--record FILE] [--replay FILE] [--tick-rate N] [--profile FILE] [--seed N] [--check-allocations FRAMES]
+//             [--versus bot [--latency MS] [--jitter MS] [--loss PERCENT] | --host PORT | --join HOST:PORT]
+// --check-allocations quits after that many frames and exits with 1 if the loop allocated once warmed up.
+int main(int argc, char** argv) {
+  // SDL has to allocate through the counted functions from the start.
+  if (!Allocations::hookSdl()) SDL_Log("Failed to hook SDL's allocator! SDL_Error: %s\n", SDL_GetError());
 
-int main() {
   Game game;
-  
-  uint64_t frame_start;
-  int frame_time;
 
   int output = game.init("Tetris", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, Window::WIDTH, Window::HEIGHT);
   if (output != 0) return 1;
 
+  // versus starts once every other option is in, whatever order they came in.
+  LinkSettings link;
+  const char* versus = nullptr;
+  const char* host = nullptr;
+  const char* join = nullptr;
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "--record")) game.record(argv[i + 1]);
+    else if (!strcmp(argv[i], "--replay") && !game.watch(argv[i + 1])) return 1;
+    else if (!strcmp(argv[i], "--tick-rate")) game.setTickRate(atoi(argv[i + 1]));
+    else if (!strcmp(argv[i], "--profile")) game.profileTo(argv[i + 1]);
+    else if (!strcmp(argv[i], "--seed")) game.setSeed(strtoull(argv[i + 1], nullptr, 10));
+    else if (!strcmp(argv[i], "--versus")) versus = argv[i + 1];
+    else if (!strcmp(argv[i], "--latency")) link.latency = std::max(0, atoi(argv[i + 1]));
+    else if (!strcmp(argv[i], "--jitter")) link.jitter = std::max(0, atoi(argv[i + 1]));
+    else if (!strcmp(argv[i], "--loss")) link.loss = std::clamp(atoi(argv[i + 1]), 0, 100);
+    else if (!strcmp(argv[i], "--host")) host = argv[i + 1];
+    else if (!strcmp(argv[i], "--join")) join = argv[i + 1];
+    else if (!strcmp(argv[i], "--check-allocations")) {
+      if (!Allocations::TRACKED) {
+        SDL_Log("Allocations aren't counted in this build, make it with TRACK_ALLOCATIONS=1\n");
+        return 1;
+      }
+
+      game.checkAllocations(std::max(1, atoi(argv[i + 1])));
+    }
+  }
+
+  if (versus && !strcmp(versus, "bot")) game.versusBot(link);
+  else if (host && !game.versusHost(atoi(host))) return 1;
+  else if (join) {
+    const char* colon = strrchr(join, ':');
+    std::string address = colon ? std::string(join, colon) : std::string(join);
+    if (!colon || !game.versusJoin(address.c_str(), atoi(colon + 1))) return 1;
+  }
+
+  // the simulation runs in fixed steps of 1 / tick rate seconds, however fast frames are drawn. it keeps up to one
+  // step ahead of the clock, so every key event read this frame already has a tick to act on.
+  const uint64_t frequency = SDL_GetPerformanceFrequency();
+  uint64_t simulated = SDL_GetPerformanceCounter();
+
   while (true) {
-    frame_start = SDL_GetTicks64();
+    uint64_t frameStart = SDL_GetPerformanceCounter();
+
+    // after a stall (a dragged window, a debugger) drop the backlog rather than fast-forward through it.
+    simulated = std::max(simulated, frameStart - frequency / 4);
 
     game.handleEvents();
     if (!game.running()) break;
 
-    game.update();
-    game.render();
+    uint64_t step = frequency / game.tickRate();
+    while (simulated < frameStart) {
+      simulated += step;
+      game.update(simulated);
+    }
 
-    frame_time = SDL_GetTicks64() - frame_start;
+    game.render();
 
-    if (FPS::FRAME_DELAY > frame_time) {
-      SDL_Delay(FPS::FRAME_DELAY - frame_time);
-    }
+    if (!game.vsync())
+      waitUntil(frameStart + frequency / FPS::FPS, frequency);
   }
 
-  exit(0);
-}
\ No newline at end of file
+  exit(game.allocatedWhenSteady() ? 1 : 0);
+}
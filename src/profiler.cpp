@@ -0,0 +1,96 @@
+#include "profiler.hpp"
+#include <algorithm>
+#include <cstdio>
+
+Profiler::Profiler():
+  on(false),
+  toMilliseconds(0),
+  starts{},
+  current{},
+  lastFrame(0),
+  allocationMark{},
+  frameCount(0)
+{}
+
+void Profiler::setEnabled(bool on) {
+  this->on = on;
+  if (!on) return;
+
+  toMilliseconds = 1000.0 / SDL_GetPerformanceFrequency();
+  current.fill(0);
+  lastFrame = SDL_GetPerformanceCounter();
+  // a phase already under way when it was switched on ends without having begun.
+  starts.fill(lastFrame);
+  allocationMark = Allocations::thisThread();
+  frameCount = 0;
+}
+
+void Profiler::endFrame() {
+  if (!on) return;
+
+  uint64_t now = SDL_GetPerformanceCounter();
+  current[Phase::Frame] = now - lastFrame;
+  lastFrame = now;
+
+  std::array<float, PHASES>& frame = samples[frameCount % FRAMES];
+  for (int i = 0; i < PHASES; i++) frame[i] = float(current[i] * toMilliseconds);
+
+  Allocations::Count allocated = Allocations::thisThread();
+  allocations[frameCount % FRAMES] = allocated - allocationMark;
+  allocationMark = allocated;
+
+  current.fill(0);
+  frameCount++;
+}
+
+// sorts the first count values in place.
+static Profiler::Summary percentiles(std::array<float, Profiler::FRAMES>& values, int count) {
+  if (count == 0) return { 0, 0, 0, 0 };
+
+  std::sort(values.begin(), values.begin() + count);
+
+  auto at = [&](int percent) { return values[(count - 1) * percent / 100]; };
+  return { at(50), at(95), at(99), values[count - 1] };
+}
+
+Profiler::Summary Profiler::summary(Phase phase) const {
+  std::array<float, FRAMES> values;
+  for (int i = 0; i < frames(); i++) values[i] = samples[i][phase];
+  return percentiles(values, frames());
+}
+
+Profiler::Summary Profiler::allocationSummary() const {
+  std::array<float, FRAMES> values;
+  for (int i = 0; i < frames(); i++) values[i] = float(allocations[i].allocations);
+  return percentiles(values, frames());
+}
+
+bool Profiler::save(const char* path) const {
+  FILE* file = fopen(path, "w");
+  if (!file) return false;
+
+  fprintf(file, "frame");
+  for (int i = 0; i < PHASES; i++) fprintf(file, ",%s", name(Phase(i)));
+  fprintf(file, ",allocations,bytes\n");
+
+  int count = frames();
+  for (int i = 0; i < count; i++) {
+    int frame = frameCount - count + i;
+    fprintf(file, "%d", frame);
+    for (int phase = 0; phase < PHASES; phase++)
+      fprintf(file, ",%.1f", samples[frame % FRAMES][phase] * 1000);
+
+    const Allocations::Count& allocated = allocations[frame % FRAMES];
+    fprintf(file, ",%llu,%llu\n", (unsigned long long)allocated.allocations, (unsigned long long)allocated.bytes);
+  }
+
+  return fclose(file) == 0;
+}
+
+const char* Profiler::name(Phase phase) {
+  static constexpr const char* names[PHASES] = {
+    "events", "update", "background", "shadow", "blocks", "score", "present", "total"
+  };
+
+  return names[phase];
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include "allocations.hpp"
+#include <array>
+
+// times each phase of a frame with the performance counter and keeps the last FRAMES frames for percentiles.
+// while off, every call is a single branch on a bool, so it stays compiled into normal builds.
+class Profiler {
+public:
+  enum Phase {
+    Events, Update, Background, Shadow, Blocks, Score, Present,
+    // the whole frame, from the end of the last one, waiting included.
+    Frame,
+    PHASES
+  };
+
+  struct Summary {
+    float p50, p95, p99, max;
+  };
+
+  // times a phase for as long as it is in scope.
+  class Scope {
+  public:
+    Scope(Profiler& profiler, Phase phase): profiler(profiler), phase(phase) { profiler.begin(phase); }
+    ~Scope() { profiler.end(phase); }
+  private:
+    Profiler& profiler;
+    Phase phase;
+  };
+
+  static constexpr int FRAMES = 512;
+
+  Profiler();
+
+  // turning it on starts over with no frames recorded.
+  void setEnabled(bool on);
+  inline bool enabled() const { return on; }
+
+  inline void begin(Phase phase) {
+    if (on) starts[phase] = SDL_GetPerformanceCounter();
+  }
+  inline void end(Phase phase) {
+    if (on) current[phase] += SDL_GetPerformanceCounter() - starts[phase];
+  }
+  // stores the phases timed since the last call as one frame.
+  void endFrame();
+
+  // percentiles in milliseconds over the recorded frames.
+  Summary summary(Phase phase) const;
+  // percentiles of the heap allocations the game's thread made per frame, in builds that count them (see Allocations).
+  Summary allocationSummary() const;
+  inline int frames() const { return frameCount < FRAMES ? frameCount : FRAMES; }
+  // one row per recorded frame, oldest first, one column per phase in microseconds, then allocations and their bytes.
+  bool save(const char* path) const;
+
+  static const char* name(Phase phase);
+private:
+  bool on;
+  double toMilliseconds;
+
+  std::array<uint64_t, PHASES> starts;
+  std::array<uint64_t, PHASES> current;
+  uint64_t lastFrame;
+
+  // in milliseconds, frameCount % FRAMES is the next slot written.
+  std::array<std::array<float, PHASES>, FRAMES> samples;
+  std::array<Allocations::Count, FRAMES> allocations;
+  Allocations::Count allocationMark;
+  int frameCount;
+};
@@ -0,0 +1,111 @@
+#include "text.hpp"
+#include <cstring>
+
+bool GlyphAtlas::build(SDL_Renderer* renderer, TTF_Font* font) {
+  destroy();
+
+  constexpr SDL_Color white = { 255, 255, 255, 255 };
+  std::array<SDL_Surface*, LAST - FIRST + 1> surfaces = {};
+
+  lineHeight = TTF_FontHeight(font);
+
+  // pack the glyphs left to right in rows of one line height each.
+  int penX = 0, penY = 0;
+  for (int c = FIRST; c <= LAST; c++) {
+    SDL_Surface* surface = TTF_RenderGlyph_Blended(font, c, white);
+    surfaces[c - FIRST] = surface;
+
+    int advance = 0;
+    TTF_GlyphMetrics(font, c, nullptr, nullptr, nullptr, nullptr, &advance);
+
+    int w = surface ? surface->w : 0;
+    if (penX + w > WIDTH) {
+      penX = 0;
+      penY += lineHeight;
+    }
+
+    glyphs[c - FIRST] = { { penX, penY, w, surface ? surface->h : 0 }, advance };
+    penX += w;
+  }
+
+  SDL_Surface* sheet = SDL_CreateRGBSurfaceWithFormat(0, WIDTH, penY + lineHeight, 32, SDL_PIXELFORMAT_RGBA32);
+
+  if (sheet) {
+    for (int c = FIRST; c <= LAST; c++) {
+      SDL_Surface* surface = surfaces[c - FIRST];
+      if (!surface) continue;
+
+      // copy the glyph's alpha as is rather than blending it onto the empty sheet.
+      SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+      SDL_Rect destination = glyphs[c - FIRST].source;
+      SDL_BlitSurface(surface, nullptr, sheet, &destination);
+    }
+
+    texture = SDL_CreateTextureFromSurface(renderer, sheet);
+    SDL_FreeSurface(sheet);
+  }
+
+  for (SDL_Surface* surface : surfaces)
+    if (surface) SDL_FreeSurface(surface);
+
+  if (!texture) return false;
+
+  SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+  return true;
+}
+
+void GlyphAtlas::destroy() {
+  if (texture) SDL_DestroyTexture(texture);
+  texture = nullptr;
+}
+
+void Label::set(const GlyphAtlas& atlas, const char* value, int x, int y, SDL_Color color) {
+  bool sameColor = color.r == this->color.r && color.g == this->color.g && color.b == this->color.b && color.a == this->color.a;
+  if (x == this->x && y == this->y && sameColor && strncmp(text, value, MAX_LENGTH) == 0) return;
+
+  strncpy(text, value, MAX_LENGTH);
+  text[MAX_LENGTH] = '\0';
+  length = strlen(text);
+
+  this->x = x;
+  this->y = y;
+  this->color = color;
+  refresh(atlas);
+}
+
+void Label::refresh(const GlyphAtlas& atlas) {
+  int w = 1, h = 1;
+  if (atlas.getTexture()) SDL_QueryTexture(atlas.getTexture(), nullptr, nullptr, &w, &h);
+
+  float penX = x;
+  quads = 0;
+
+  for (int i = 0; i < length; i++) {
+    const GlyphAtlas::Glyph& glyph = atlas.glyph(text[i]);
+    const SDL_Rect& source = glyph.source;
+
+    float left = penX, top = y, right = penX + source.w, bottom = y + source.h;
+    float u0 = float(source.x) / w, v0 = float(source.y) / h;
+    float u1 = float(source.x + source.w) / w, v1 = float(source.y + source.h) / h;
+
+    SDL_Vertex* quad = &vertices[quads * 4];
+    quad[0] = { { left, top }, color, { u0, v0 } };
+    quad[1] = { { right, top }, color, { u1, v0 } };
+    quad[2] = { { right, bottom }, color, { u1, v1 } };
+    quad[3] = { { left, bottom }, color, { u0, v1 } };
+
+    int* index = &indices[quads * 6];
+    int base = quads * 4;
+    index[0] = base; index[1] = base + 1; index[2] = base + 2;
+    index[3] = base; index[4] = base + 2; index[5] = base + 3;
+
+    quads++;
+    penX += glyph.advance;
+  }
+}
+
+void Label::draw(SDL_Renderer* renderer, const GlyphAtlas& atlas) const {
+  if (!atlas.getTexture() || quads == 0) return;
+
+  SDL_RenderGeometry(renderer, atlas.getTexture(), vertices.data(), quads * 4, indices.data(), quads * 6);
+}
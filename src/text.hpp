@@ -0,0 +1,62 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <array>
+
+// every printable ASCII glyph rasterised once, at the size it is shown, into a single texture.
+class GlyphAtlas {
+public:
+  struct Glyph {
+    SDL_Rect source;
+    int advance;
+  };
+
+  GlyphAtlas(): texture(nullptr), lineHeight(0) {}
+  ~GlyphAtlas() { destroy(); }
+
+  GlyphAtlas(const GlyphAtlas&) = delete;
+  GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+  bool build(SDL_Renderer* renderer, TTF_Font* font);
+  void destroy();
+
+  inline SDL_Texture* getTexture() const { return texture; }
+  inline int getLineHeight() const { return lineHeight; }
+  // characters outside the atlas show as a space.
+  inline const Glyph& glyph(char c) const {
+    return glyphs[c >= FIRST && c <= LAST ? c - FIRST : 0];
+  }
+private:
+  static constexpr char FIRST = ' ';
+  static constexpr char LAST = '~';
+  static constexpr int WIDTH = 512;
+
+  SDL_Texture* texture;
+  int lineHeight;
+  std::array<Glyph, LAST - FIRST + 1> glyphs;
+};
+
+// a line of text kept as ready-made quads into the atlas. setting the same text again costs a string compare,
+// and drawing is a single SDL_RenderGeometry call.
+class Label {
+public:
+  static constexpr int MAX_LENGTH = 64;
+
+  Label(): length(0), color({ 0, 0, 0, 0 }), quads(0), x(0), y(0) { text[0] = '\0'; }
+
+  // longer text is cut off at MAX_LENGTH characters.
+  void set(const GlyphAtlas& atlas, const char* value, int x, int y, SDL_Color color);
+  // lays the text out again, e.g. after the atlas was rebuilt.
+  void refresh(const GlyphAtlas& atlas);
+  void draw(SDL_Renderer* renderer, const GlyphAtlas& atlas) const;
+private:
+  char text[MAX_LENGTH + 1];
+  int length;
+  SDL_Color color;
+
+  std::array<SDL_Vertex, MAX_LENGTH * 4> vertices;
+  std::array<int, MAX_LENGTH * 6> indices;
+  int quads;
+  int x, y;
+};
@@ -0,0 +1,40 @@
+#include "tile_batch.hpp"
+
+void TileBatch::resize(int tileSize) {
+  size = tileSize;
+  faceOffset = tileSize / 8;
+}
+
+void TileBatch::add(int x, int y, const Color& color) {
+  int index = 0;
+  while (index < groupCount && groups[index].color != color) index++;
+
+  if (index == groupCount) {
+    if (groupCount == MAX_COLORS) return;
+
+    groups[groupCount].color = color;
+    groups[groupCount].count = 0;
+    groupCount++;
+  }
+
+  Group& group = groups[index];
+  if (group.count == CAPACITY) return;
+
+  group.edges[group.count] = { x + 1, y + 1, size - 1, size - 1 };
+  group.faces[group.count] = { x + faceOffset, y + faceOffset, size - faceOffset * 2, size - faceOffset * 2 };
+  group.count++;
+}
+
+void TileBatch::flush(SDL_Renderer* renderer) {
+  for (int i = 0; i < groupCount; i++) {
+    const Group& group = groups[i];
+
+    SDL_SetRenderDrawColor(renderer, group.color.r, group.color.g, group.color.b, 200);
+    SDL_RenderFillRects(renderer, group.edges.data(), group.count);
+
+    SDL_SetRenderDrawColor(renderer, group.color.r, group.color.g, group.color.b, 255);
+    SDL_RenderFillRects(renderer, group.faces.data(), group.count);
+  }
+
+  groupCount = 0;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include "constants.hpp"
+#include <array>
+
+// collects tiles grouped by color, so a frame costs two SDL_RenderFillRects calls per color
+// (the translucent edge, then the solid face) instead of two draw calls per tile.
+// tiles in one batch must not overlap; draw layers that do (like the ghost under the active block) as separate batches.
+class TileBatch {
+public:
+  TileBatch(): groupCount(0) { resize(TILE_SIZE); }
+
+  // pixel size of the tiles added from now on.
+  void resize(int tileSize);
+  // x and y are the window position of the tile's top left corner.
+  void add(int x, int y, const Color& color);
+  void flush(SDL_Renderer* renderer);
+private:
+  // every board tile plus a block on top of it.
+  static constexpr int CAPACITY = TOTAL_TILE_COUNT + 4;
+  // one per block color, plus the ghost and anything else drawn as tiles.
+  static constexpr int MAX_COLORS = 10;
+
+  struct Group {
+    Color color;
+    int count;
+    std::array<SDL_Rect, CAPACITY> edges;
+    std::array<SDL_Rect, CAPACITY> faces;
+  };
+
+  std::array<Group, MAX_COLORS> groups;
+  int groupCount;
+
+  int size;
+  // the solid face sits this far inside the translucent edge.
+  int faceOffset;
+};
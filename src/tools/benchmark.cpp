@@ -0,0 +1,371 @@
+// times the core rules operations over a fixed corpus of boards and reports ns/op with its spread.
+// the corpus and every seed are fixed, so runs on the same machine can be compared between commits.
+// usage: benchmark [--samples N] [--filter TEXT] [--csv]
+
+#include "../engine/bot.hpp"
+#include "../engine/engine.hpp"
+#include "../engine/evaluator.hpp"
+#include "../engine/pieces.hpp"
+#include "../engine/placements.hpp"
+#include "../engine/rewind.hpp"
+#include "../engine/vector_env.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// operations run per timed sample, each on its own copy of a corpus state.
+constexpr int BATCH = 1024;
+// copies worked on between refreshes. few enough (about 27 KB of engines) to stay in L1, so cheap operations are
+// timed rather than the cache misses of fetching their state. the cold rows work on all BATCH at once instead.
+constexpr int HOT = 32;
+constexpr int WARMUP = 3;
+
+// results are folded in here so the compiler can't drop the calls.
+static volatile long sink;
+// what a pair of Clock::now() calls costs on its own, taken off every timed stretch.
+static double clockCost;
+
+static double measureClock() {
+  double cost = 1e9;
+  for (int i = 0; i < 1000; i++) {
+    Clock::time_point start = Clock::now();
+    cost = std::min(cost, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+  }
+
+  return cost;
+}
+
+struct Options {
+  int samples = 30;
+  const char* filter = nullptr;
+  bool csv = false;
+};
+
+struct Result {
+  double mean, deviation, min;
+};
+
+static Result summarize(const std::vector<double>& times) {
+  double mean = 0, min = times[0];
+  for (double time : times) { mean += time; min = std::min(min, time); }
+  mean /= times.size();
+
+  double variance = 0;
+  for (double time : times) variance += (time - mean) * (time - mean);
+
+  return { mean, std::sqrt(variance / times.size()), min };
+}
+
+// runs op on BATCH fresh copies of the states per sample, copies of them at a time. copying happens outside the
+// timed loops.
+template<typename State, typename Op>
+static Result measure(const std::vector<State>& states, int samples, int copies, Op op) {
+  std::vector<State> work(copies, states[0]);
+  std::vector<double> times;
+
+  for (int sample = -WARMUP; sample < samples; sample++) {
+    long total = 0;
+    double elapsed = 0;
+
+    for (int done = 0; done < BATCH; done += copies) {
+      for (int i = 0; i < copies; i++) work[i] = states[(done + i) % states.size()];
+
+      Clock::time_point start = Clock::now();
+      for (State& engine : work) total += op(engine);
+      elapsed += std::chrono::duration<double, std::nano>(Clock::now() - start).count() - clockCost;
+    }
+
+    sink = sink + total;
+    if (sample >= 0) times.push_back(elapsed / BATCH);
+  }
+
+  return summarize(times);
+}
+
+// times op, which does operations worth of work in one go that can't be split into copies of a state.
+template<typename Op>
+static Result measureWhole(int samples, int operations, Op op) {
+  std::vector<double> times;
+
+  for (int sample = -WARMUP; sample < samples; sample++) {
+    Clock::time_point start = Clock::now();
+    op();
+    double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    if (sample >= 0) times.push_back(elapsed / operations);
+  }
+
+  return summarize(times);
+}
+
+static void report(const Options& options, const char* operation, const char* corpus, const Result& result) {
+  if (options.csv) printf("%s,%s,%.2f,%.2f,%.2f\n", operation, corpus, result.mean, result.deviation, result.min);
+  else printf("  %-24s %-12s %9.2f %8.2f %9.2f %6.1f%%\n", operation, corpus, result.mean, result.deviation, result.min,
+    result.mean > 0 ? result.deviation / result.mean * 100 : 0);
+}
+
+template<typename State, typename Op>
+static void run(const Options& options, const char* operation, const char* corpus, const std::vector<State>& states, Op op,
+                int copies = HOT) {
+  std::string name = std::string(operation) + " " + corpus;
+  if (options.filter && name.find(options.filter) == std::string::npos) return;
+
+  report(options, operation, corpus, measure(states, options.samples, copies, op));
+}
+
+static Board boardFrom(const char* const* rows, int count) {
+  Board board;
+  for (int i = 0; i < count; i++) {
+    // rows are listed top down and end at the floor.
+    int y = count - 1 - i;
+    for (int x = 0; x < COLUMNS; x++)
+      if (rows[i][x] == '#') board.set(x, y, Board::GARBAGE);
+  }
+
+  return board;
+}
+
+template<typename State = Engine>
+static State withBoard(const typename State::Board& board, BlockType type) {
+  State engine(1);
+  engine.reset();
+  engine.setBoard(board);
+  engine.spawnBlock(type);
+  return engine;
+}
+
+// states met in real play: a greedy one-piece-lookahead player, sampled every few pieces across several games.
+static std::vector<Engine> realistic() {
+  TaskPool pool(1);
+  Bot bot(pool);
+  Placements placements;
+  std::vector<Input> inputs;
+  std::vector<Engine> states;
+
+  for (uint64_t seed = 1; seed <= 8; seed++) {
+    Engine engine(seed);
+    engine.reset();
+
+    for (int piece = 0; piece < 120 && !engine.over(); piece++) {
+      if (piece % 5 == 0) states.push_back(engine);
+
+      const Block& block = engine.block();
+      placements.generate(engine.getBoard(), block.type, block.x, block.y, block.rotation);
+
+      Engine best = engine;
+      float bestScore = -1e30f;
+
+      for (const Placement& placement : placements.all()) {
+        Engine next = engine;
+        placements.path(placement, inputs);
+        for (Input input : inputs) next.input(input);
+
+        float score = bot.evaluate(next.getBoard()) + (next.getLinesCleared() - engine.getLinesCleared()) * 0.76f;
+        if (!next.over() && score > bestScore) { best = next; bestScore = score; }
+      }
+
+      if (bestScore == -1e30f) break;
+      engine = best;
+    }
+  }
+
+  return states;
+}
+
+// a tall, ragged stack a few rows from the top.
+static std::vector<Engine> tall() {
+  static const char* rows[] = {
+    "##.#######", "#.########", "########.#", ".#########", "######.###", "###.######",
+    "#########.", "##.#######", "#######.##", "#.########", "####.#####", "##########",
+    "######.###", "#.########", "#######.##", ".#########",
+  };
+
+  std::vector<Engine> states;
+  for (int type = BlockType::I; type <= BlockType::Z; type++)
+    states.push_back(withBoard(boardFrom(rows, 16), BlockType(type)));
+  return states;
+}
+
+// rows full of scattered holes, so nothing ever clears and every block lands early.
+static std::vector<Engine> cheese() {
+  Xoshiro256 random;
+  random.seed(7);
+
+  Board board;
+  for (int y = 0; y < ROWS / 2; y++)
+    for (int x = 0; x < COLUMNS; x++)
+      if (random.below(3) != 0) board.set(x, y, Board::GARBAGE);
+
+  std::vector<Engine> states;
+  for (int type = BlockType::I; type <= BlockType::Z; type++)
+    states.push_back(withBoard(board, BlockType(type)));
+  return states;
+}
+
+template<typename State = Engine>
+static std::vector<State> empty() {
+  std::vector<State> states;
+  for (int type = BlockType::I; type <= BlockType::Z; type++)
+    states.push_back(withBoard<State>(typename State::Board(), BlockType(type)));
+  return states;
+}
+
+// every tile filled except the ones the active block stands on, so every kick of every rotation is tried and fails.
+static std::vector<Engine> enclosed() {
+  std::vector<Engine> states;
+
+  for (int type = BlockType::I; type <= BlockType::Z; type++) {
+    if (type == BlockType::O) continue;
+
+    Engine engine = withBoard(Board(), BlockType(type));
+    for (int i = 0; i < 10; i++) engine.moveDown();
+
+    std::array<bool, TOTAL_TILE_COUNT> free = {};
+    for (const Coords& tile : Pieces::cells(engine.block()))
+      free[tile.y * COLUMNS + tile.x] = true;
+
+    Board board;
+    for (int y = 0; y < ROWS; y++)
+      for (int x = 0; x < COLUMNS; x++)
+        if (!free[y * COLUMNS + x]) board.set(x, y, Board::GARBAGE);
+
+    engine.setBoard(board);
+    states.push_back(engine);
+  }
+
+  return states;
+}
+
+// an upright I resting in the right-hand well with lines rows under it full everywhere else, ready to place.
+static std::vector<Engine> clearing(int lines) {
+  Board board;
+  for (int y = 0; y < lines; y++)
+    for (int x = 0; x < COLUMNS - 1; x++) board.set(x, y, Board::GARBAGE);
+
+  Engine engine = withBoard(board, BlockType::I);
+  engine.rotate(1);
+  while (engine.moveHorizontal(1));
+  while (engine.moveDown());
+
+  return { engine };
+}
+
+int main(int argc, char** argv) {
+  Options options;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--csv")) options.csv = true;
+    else if (i + 1 < argc && !strcmp(argv[i], "--samples")) options.samples = std::max(1, atoi(argv[++i]));
+    else if (i + 1 < argc && !strcmp(argv[i], "--filter")) options.filter = argv[++i];
+  }
+
+  std::vector<Engine> play = realistic(), stacked = tall(), holes = cheese(), open = empty(), boxed = enclosed();
+  clockCost = measureClock();
+
+  if (options.csv) printf("operation,corpus,mean_ns,stddev_ns,min_ns\n");
+  else {
+    printf("%d samples of %d ops, corpus of %zu played states\n", options.samples, BATCH, play.size());
+    printf("  %-24s %-12s %9s %8s %9s %7s\n", "operation", "corpus", "ns/op", "stddev", "min", "cv");
+  }
+
+  run(options, "blockCanDrop", "realistic", play, [](Engine& engine) { return engine.blockCanDrop(); });
+  run(options, "blockCanDrop", "tall", stacked, [](Engine& engine) { return engine.blockCanDrop(); });
+
+  run(options, "moveDown", "realistic", play, [](Engine& engine) { return engine.moveDown(); });
+  run(options, "moveDown", "empty", open, [](Engine& engine) { return engine.moveDown(); });
+
+  run(options, "moveHorizontal", "realistic", play, [](Engine& engine) { return engine.moveHorizontal(1); });
+  run(options, "moveHorizontal", "cheese", holes, [](Engine& engine) { return engine.moveHorizontal(-1); });
+
+  run(options, "rotate", "realistic", play, [](Engine& engine) { return engine.rotate(1); });
+  run(options, "rotate", "tall", stacked, [](Engine& engine) { return engine.rotate(-1); });
+  run(options, "rotate (all kicks fail)", "enclosed", boxed, [](Engine& engine) { return engine.rotate(1); });
+
+  run(options, "endLocation", "realistic", play, [](Engine& engine) { return engine.endLocation().y; });
+  run(options, "endLocation", "empty", open, [](Engine& engine) { return engine.endLocation().y; });
+  run(options, "endLocation", "cheese", holes, [](Engine& engine) { return engine.endLocation().y; });
+
+  for (int lines = 0; lines <= 4; lines++) {
+    char name[32];
+    snprintf(name, sizeof(name), "place (%d lines)", lines);
+    run(options, name, "well", clearing(lines), [](Engine& engine) { return engine.place(); });
+  }
+
+  run(options, "spawnBlock", "realistic", play, [](Engine& engine) { engine.spawnBlock(); return 0; });
+  run(options, "spawnBlock", "tall", stacked, [](Engine& engine) { engine.spawnBlock(); return 0; });
+
+  // a few of the above with each of BATCH states fetched from further out than L1, as when stepping many games in turn.
+  run(options, "blockCanDrop (cold)", "realistic", play, [](Engine& engine) { return engine.blockCanDrop(); }, BATCH);
+  run(options, "moveHorizontal (cold)", "realistic", play, [](Engine& engine) { return engine.moveHorizontal(1); }, BATCH);
+  run(options, "rotate (cold)", "realistic", play, [](Engine& engine) { return engine.rotate(1); }, BATCH);
+  run(options, "endLocation (cold)", "realistic", play, [](Engine& engine) { return engine.endLocation().y; }, BATCH);
+
+  // board scoring with every kernel this CPU can run, one board per call and then the whole corpus in one call.
+  std::vector<const Board*> boards;
+  for (int i = 0; i < BATCH; i++) boards.push_back(&play[i % play.size()].getBoard());
+  std::vector<float> scores(BATCH);
+
+  for (int kernel = Evaluator::Scalar; kernel <= Evaluator::best(); kernel++) {
+    Evaluator evaluator(EvalWeights{}, Evaluator::Kernel(kernel));
+    char name[32];
+
+    snprintf(name, sizeof(name), "evaluate (%s)", Evaluator::name(evaluator.kernel()));
+    run(options, name, "realistic", play, [&](Engine& engine) { return long(evaluator.evaluate(engine.getBoard())); });
+
+    snprintf(name, sizeof(name), "evaluate batch (%s)", Evaluator::name(evaluator.kernel()));
+    if (!options.filter || (std::string(name) + " realistic").find(options.filter) != std::string::npos) {
+      report(options, name, "realistic", measureWhole(options.samples, BATCH, [&]() {
+        evaluator.evaluate(boards.data(), scores.data(), BATCH);
+        sink = sink + long(scores[0]);
+      }));
+    }
+  }
+
+  // into and back out of a full rewind buffer, the slot it lands in unlikely to be cached.
+  Rewind rewind;
+  rewind.reserve(Rules::REWIND_SECONDS, Rules::TICK_RATE);
+  Engine filler;
+  while (rewind.size() < rewind.capacity()) rewind.push(filler);
+
+  run(options, "snapshot", "realistic", play, [&](Engine& engine) { rewind.push(engine); return 0; });
+  run(options, "snapshot + restore", "realistic", play, [&](Engine& engine) { rewind.push(engine); return rewind.pop(engine); });
+
+  // a batched step of BATCH training environments, per environment. random actions, so games are short and
+  // restarts are part of the cost.
+  if (!options.filter || std::string("env step batched").find(options.filter) != std::string::npos) {
+    VectorEnv environments(BATCH, 1);
+    std::vector<uint8_t> board(BATCH * VectorEnv::BOARD_SIZE), done(BATCH);
+    std::vector<int8_t> piece(BATCH), hold(BATCH), next(BATCH * Rules::PREVIEW);
+    std::vector<float> reward(BATCH);
+    std::vector<int32_t> actions(BATCH);
+    VectorEnv::Buffers out = { board.data(), piece.data(), hold.data(), next.data(), reward.data(), done.data() };
+
+    Xoshiro256 random(3);
+    environments.reset(out);
+    report(options, "env step", "batched", measureWhole(options.samples, BATCH, [&]() {
+      for (int32_t& action : actions) action = random.below(VectorEnv::ACTIONS);
+      environments.step(actions.data(), out);
+    }));
+  }
+
+  // the same operations on other board sizes, to check they keep up with the standard one.
+  using Wide = BasicEngine<COLUMNS * 2, ROWS, HIDDEN_ROWS>;
+  using Tall = BasicEngine<COLUMNS, ROWS * 2, HIDDEN_ROWS>;
+  std::vector<Wide> wideBoards = empty<Wide>();
+  std::vector<Tall> tallBoards = empty<Tall>();
+
+  run(options, "moveHorizontal", "empty 20x20", wideBoards, [](Wide& engine) { return engine.moveHorizontal(1); });
+  run(options, "moveHorizontal", "empty 10x40", tallBoards, [](Tall& engine) { return engine.moveHorizontal(1); });
+  run(options, "endLocation", "empty 20x20", wideBoards, [](Wide& engine) { return engine.endLocation().y; });
+  run(options, "endLocation", "empty 10x40", tallBoards, [](Tall& engine) { return engine.endLocation().y; });
+  run(options, "spawnBlock", "empty 20x20", wideBoards, [](Wide& engine) { engine.spawnBlock(); return 0; });
+  run(options, "spawnBlock", "empty 10x40", tallBoards, [](Tall& engine) { engine.spawnBlock(); return 0; });
+
+  return 0;
+}
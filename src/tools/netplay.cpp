@@ -0,0 +1,172 @@
+// plays versus matches between two rollback sessions over a simulated link, faster than real time, and reports how
+// much re-simulating the latency and jitter cost and whether both ends ended up agreeing on the match.
+// usage: netplay [--matches N] [--seconds N] [--latency MS] [--jitter MS] [--loss PERCENT] [--seed N]
+//                [--tick-rate N] [--frame-rate N]
+
+#include "../engine/placements.hpp"
+#include "../engine/rollback.hpp"
+#include "../engine/transport.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+  int matches = 20;
+  int seconds = 60;
+  LinkSettings link;
+  uint64_t seed = 1;
+  int tickRate = Rules::TICK_RATE;
+  int frameRate = 60;
+};
+
+// one end of a match: a player dropping each block into a random reachable spot, a few ticks per input.
+struct Side {
+  Rollback session;
+  Placements placements;
+  Xoshiro256 random;
+  std::vector<Input> path;
+  size_t next = 0;
+  int wait = 0;
+
+  TickInput decide() {
+    const Engine& engine = session.match().player(session.side());
+    TickInput input;
+
+    if (next == path.size() && --wait <= 0) {
+      const Block& block = engine.block();
+      placements.generate(engine.getBoard(), block.type, block.x, block.y, block.rotation);
+
+      if (placements.all().empty()) path.assign(1, Input::HardDrop);
+      else placements.path(placements.all()[random.below(placements.all().size())], path);
+
+      next = 0;
+      wait = engine.toTicks(100);
+    }
+
+    // an input every few ticks, so both ends press things while the other is still predicting them.
+    if (next < path.size() && random.below(4) == 0) input.add(path[next++]);
+    return input;
+  }
+};
+
+// everything both ends should agree on once every input is in.
+static uint64_t fingerprint(const Match& match) {
+  uint64_t hash = 1469598103934665603ull;
+  auto mix = [&](uint64_t value) { hash = (hash ^ value) * 1099511628211ull; };
+
+  mix(match.getFrame());
+  for (int side = 0; side < 2; side++) {
+    const Engine& engine = match.player(side);
+    mix(engine.getScore());
+    mix(engine.getPieces());
+    mix(engine.getPendingGarbage());
+    mix(engine.block().x << 8 | engine.block().y);
+    for (Board::Cell cell : engine.getBoard().cells()) mix(cell);
+  }
+
+  return hash;
+}
+
+int main(int argc, char** argv) {
+  Options options;
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "--matches")) options.matches = std::max(1, atoi(argv[i + 1]));
+    else if (!strcmp(argv[i], "--seconds")) options.seconds = std::max(1, atoi(argv[i + 1]));
+    else if (!strcmp(argv[i], "--latency")) options.link.latency = std::max(0, atoi(argv[i + 1]));
+    else if (!strcmp(argv[i], "--jitter")) options.link.jitter = std::max(0, atoi(argv[i + 1]));
+    else if (!strcmp(argv[i], "--loss")) options.link.loss = std::clamp(atoi(argv[i + 1]), 0, 100);
+    else if (!strcmp(argv[i], "--seed")) options.seed = strtoull(argv[i + 1], nullptr, 10);
+    else if (!strcmp(argv[i], "--tick-rate")) options.tickRate = std::max(1, atoi(argv[i + 1]));
+    else if (!strcmp(argv[i], "--frame-rate")) options.frameRate = std::max(1, atoi(argv[i + 1]));
+  }
+
+  printf("%d matches of up to %d s, %d ms latency, %d ms jitter, %d%% loss, %d ticks/s\n", options.matches,
+    options.seconds, options.link.latency, options.link.jitter, options.link.loss, options.tickRate);
+
+  Side sides[2];
+  SimulatedLink link(options.link, options.seed);
+
+  uint64_t ticks = 0, rollbacks = 0, resimulated = 0, stalls = 0, desyncs = 0, flagged = 0;
+  int worstTick = 0, worstFrame = 0;
+  // a single update can be preempted for milliseconds, so time is only totalled and frames are counted in ticks.
+  double resimulating = 0;
+
+  for (int match = 0; match < options.matches; match++) {
+    uint64_t seed = options.seed + match;
+    link.clear();
+
+    for (int side = 0; side < 2; side++) {
+      sides[side].session.start(seed, side, options.tickRate);
+      sides[side].random.seed(seed * 2 + side);
+      sides[side].path.clear();
+      sides[side].next = 0;
+      sides[side].wait = 0;
+    }
+
+    uint64_t end = uint64_t(options.seconds) * options.tickRate;
+    uint64_t tick = 0;
+    int frameTicks = 0;
+
+    // play on until both ends have stopped where the match ended (or ran out of time) and agree on it.
+    while (true) {
+      link.setTime(tick * 1000000 / options.tickRate);
+
+      bool done = true;
+      for (int side = 0; side < 2; side++) {
+        Side& player = sides[side];
+        Transport& transport = link.end(side);
+
+        Clock::time_point start = Clock::now();
+        int replayed = player.session.poll(transport);
+        double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+        if (replayed > 0) resimulating += elapsed;
+        frameTicks += replayed;
+        worstTick = std::max(worstTick, replayed);
+
+        const Match& state = player.session.match();
+        if (!state.over() && state.getFrame() < end) player.session.advance(player.decide());
+        player.session.send(transport);
+
+        done &= player.session.settled() && (player.session.match().over() || player.session.getFrame() >= end);
+      }
+
+      tick++;
+
+      // frames are where the player would notice: everything re-simulated between two of them adds up.
+      if (tick % std::max(1, options.tickRate / options.frameRate) == 0) {
+        worstFrame = std::max(worstFrame, frameTicks);
+        frameTicks = 0;
+      }
+
+      if (done) break;
+    }
+
+    if (fingerprint(sides[0].session.match()) != fingerprint(sides[1].session.match())) desyncs++;
+
+    ticks += sides[0].session.match().getFrame();
+    for (const Side& side : sides) {
+      rollbacks += side.session.stats().rollbacks;
+      resimulated += side.session.stats().resimulated;
+      stalls += side.session.stats().stalls;
+      flagged += side.session.stats().desyncs;
+    }
+  }
+
+  printf("%llu ticks played, %llu rollbacks re-simulating %llu ticks (%.2f per rollback), %llu stalls\n",
+    (unsigned long long)ticks, (unsigned long long)rollbacks, (unsigned long long)resimulated,
+    rollbacks ? double(resimulated) / rollbacks : 0.0, (unsigned long long)stalls);
+  double perTick = resimulated ? resimulating / resimulated : 0;
+  printf("re-simulation: %.0f ns per tick, worst %d ticks in one update, worst frame %d ticks (%.1f us at that rate)\n",
+    perTick, worstTick, worstFrame, worstFrame * perTick / 1000);
+  printf("%llu of %d matches desynced, %llu checksum mismatches seen in play\n", (unsigned long long)desyncs,
+    options.matches, (unsigned long long)flagged);
+
+  return desyncs == 0 && flagged == 0 ? 0 : 1;
+}
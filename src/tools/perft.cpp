@@ -0,0 +1,340 @@
+// counts every distinct sequence of placements to a given depth, like perft in chess engines. each move is a hard
+// drop into one of the spots Placements finds reachable, made through Engine::input with the path there, so both
+// the search and the engine's movement, SRS rotation and locking have to agree for the counts to stay put.
+// --check runs a fixed set of positions against counts recorded earlier and fails on any difference.
+// usage: perft [--depth N] [--seed N] [--queue PIECES] [--board empty|tall|cheese] [--threads N] [--no-hold]
+//              [--divide] [--check]
+
+#include "../engine/engine.hpp"
+#include "../engine/placements.hpp"
+#include "../engine/task_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+  int depth = 3;
+  uint64_t seed = 1;
+  // blocks to deal instead of the seed's, e.g. "TIOSZ". past its end the seed's sequence carries on.
+  std::string queue;
+  std::string board = "empty";
+  unsigned threads = std::thread::hardware_concurrency();
+  bool hold = true;
+  bool divide = false;
+};
+
+// a fixed position and the counts it gave, one per depth from 1.
+struct Known {
+  const char* board;
+  uint64_t seed;
+  const char* queue;
+  bool hold;
+  std::vector<uint64_t> counts;
+};
+
+static const std::vector<Known> KNOWN = {
+  { "empty", 1, "", true, { 26, 1203, 43054 } },
+  { "empty", 1, "SZO", false, { 17, 296, 2730 } },
+  { "tall", 1, "TIL", true, { 51, 2914, 132271 } },
+  { "cheese", 2, "", true, { 34, 1196, 64357 } },
+};
+
+static const char NAMES[] = " IOTLJSZ";
+
+static BlockType piece(char name) {
+  const char* found = name ? strchr(NAMES + 1, toupper(name)) : nullptr;
+  return found ? BlockType(found - NAMES) : BlockType::None;
+}
+
+// a position in the tree, and where the queue is up to.
+struct Position {
+  Engine engine;
+  int next;
+};
+
+// each thread's scratch: a placement search per ply, as the ones above it are still being walked.
+struct Worker {
+  std::vector<std::unique_ptr<Placements>> plies;
+  std::vector<Input> inputs;
+  uint64_t nodes = 0;
+};
+
+class Perft {
+public:
+  Perft(const Options& options, TaskPool& pool):
+    options(options),
+    pool(pool)
+  {
+    workers.resize(pool.size());
+    for (Worker& worker : workers)
+      for (int ply = 0; ply < std::max(options.depth, 1); ply++)
+        worker.plies.push_back(std::make_unique<Placements>());
+  }
+
+  // the root's moves are shared out across the pool, each subtree counted on whichever thread takes it.
+  uint64_t run(const Position& root, std::vector<std::pair<std::string, uint64_t>>* divided = nullptr) {
+    std::vector<Position> children;
+    std::vector<std::string> names;
+    // the thread calling parallelFor counts as the last worker.
+    Worker& caller = workers.back();
+
+    moves(root, *caller.plies[0], caller.inputs, [&](const Position& child, const Placement& placement, bool held) {
+      children.push_back(child);
+      names.push_back(describe(placement, held));
+    });
+
+    if (options.depth <= 1) {
+      if (divided) for (const std::string& name : names) divided->push_back({ name, 1 });
+      caller.nodes += children.size();
+      return children.size();
+    }
+
+    std::vector<uint64_t> counts(children.size());
+    pool.parallelFor(children.size(), [&](int i) {
+      Worker& worker = workers[TaskPool::worker()];
+      counts[i] = count(children[i], options.depth - 1, 1, worker);
+    });
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < children.size(); i++) {
+      total += counts[i];
+      if (divided) divided->push_back({ names[i], counts[i] });
+    }
+
+    return total;
+  }
+
+  uint64_t nodes() const {
+    uint64_t total = 0;
+    for (const Worker& worker : workers) total += worker.nodes;
+    return total;
+  }
+private:
+  // calls fn with every position one placement away, and whether the block was held first.
+  template <typename Fn>
+  void moves(const Position& position, Placements& placements, std::vector<Input>& inputs, Fn fn) const {
+    auto branch = [&](const Position& start, bool held) {
+      generate(start.engine, placements);
+
+      for (const Placement& placement : placements.all()) {
+        Position child = start;
+        placements.path(placement, inputs);
+        for (Input input : inputs) child.engine.input(input);
+        if (!child.engine.over()) deal(child);
+
+        fn(child, placement, held);
+      }
+    };
+
+    branch(position, false);
+
+    const Engine& engine = position.engine;
+    if (!options.hold || engine.isHoldLocked() || engine.getHold() == engine.block().type) return;
+
+    Position held = position;
+    bool empty = engine.getHold() == BlockType::None;
+    held.engine.input(Input::Hold);
+    if (empty) deal(held);
+    if (!held.engine.over()) branch(held, true);
+  }
+
+  static void generate(const Engine& engine, Placements& placements) {
+    const Block& block = engine.block();
+    placements.generate(engine.getBoard(), block.type, block.x, block.y, block.rotation);
+  }
+
+  // after the engine has dealt itself a block, swaps in the queue's next one while the queue lasts.
+  void deal(Position& position) const {
+    if (position.next < (int)options.queue.size()) position.engine.spawnBlock(piece(options.queue[position.next]));
+    position.next++;
+  }
+
+  uint64_t count(const Position& position, int depth, int ply, Worker& worker) {
+    worker.nodes++;
+    if (position.engine.over()) return 0;
+
+    uint64_t total = 0;
+    Placements& placements = *worker.plies[ply];
+
+    if (depth == 1) {
+      // the last ply only needs counting, not playing.
+      generate(position.engine, placements);
+      total = placements.all().size();
+
+      const Engine& engine = position.engine;
+      if (options.hold && !engine.isHoldLocked() && engine.getHold() != engine.block().type) {
+        Position held = position;
+        bool empty = engine.getHold() == BlockType::None;
+        held.engine.input(Input::Hold);
+        if (empty) deal(held);
+
+        if (!held.engine.over()) {
+          generate(held.engine, placements);
+          total += placements.all().size();
+        }
+      }
+
+      worker.nodes += total;
+      return total;
+    }
+
+    moves(position, placements, worker.inputs, [&](const Position& child, const Placement&, bool) {
+      total += count(child, depth - 1, ply + 1, worker);
+    });
+
+    return total;
+  }
+
+  static std::string describe(const Placement& placement, bool held) {
+    char text[32];
+    snprintf(text, sizeof(text), "%s%c r%d x%d y%d", held ? "hold " : "", NAMES[placement.type], placement.rotation,
+      placement.x, placement.y);
+    return text;
+  }
+
+  const Options& options;
+  TaskPool& pool;
+  std::vector<Worker> workers;
+};
+
+static Board boardFrom(const char* const* rows, int count) {
+  Board board;
+  for (int i = 0; i < count; i++) {
+    // rows are listed top down and end at the floor.
+    int y = count - 1 - i;
+    for (int x = 0; x < COLUMNS; x++)
+      if (rows[i][x] == '#') board.set(x, y, Board::GARBAGE);
+  }
+
+  return board;
+}
+
+// the same fixed boards as the benchmark: nothing, a tall ragged stack, and scattered garbage.
+static bool makeBoard(const std::string& name, Board& board) {
+  static const char* tall[] = {
+    "##.#######", "#.########", "########.#", ".#########", "######.###", "###.######",
+    "#########.", "##.#######", "#######.##", "#.########", "####.#####", "##########",
+    "######.###", "#.########", "#######.##", ".#########",
+  };
+
+  board = Board();
+  if (name == "empty") return true;
+  if (name == "tall") {
+    board = boardFrom(tall, 16);
+    return true;
+  }
+
+  if (name == "cheese") {
+    Xoshiro256 random;
+    random.seed(7);
+    for (int y = 0; y < ROWS / 2; y++)
+      for (int x = 0; x < COLUMNS; x++)
+        if (random.below(3) != 0) board.set(x, y, Board::GARBAGE);
+    return true;
+  }
+
+  return false;
+}
+
+static bool makeRoot(const Options& options, Position& root) {
+  Board board;
+  if (!makeBoard(options.board, board)) return false;
+
+  root.engine = Engine(options.seed);
+  root.engine.reset();
+  root.engine.setBoard(board);
+  root.engine.spawnBlock(root.engine.block().type);
+  root.next = 0;
+
+  if (!options.queue.empty()) {
+    root.engine.spawnBlock(piece(options.queue[0]));
+    root.next = 1;
+  }
+
+  return true;
+}
+
+int main(int argc, char** argv) {
+  Options options;
+  bool check = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--no-hold")) options.hold = false;
+    else if (!strcmp(argv[i], "--divide")) options.divide = true;
+    else if (!strcmp(argv[i], "--check")) check = true;
+    else if (i + 1 < argc && !strcmp(argv[i], "--depth")) options.depth = std::max(1, atoi(argv[++i]));
+    else if (i + 1 < argc && !strcmp(argv[i], "--seed")) options.seed = strtoull(argv[++i], nullptr, 10);
+    else if (i + 1 < argc && !strcmp(argv[i], "--queue")) options.queue = argv[++i];
+    else if (i + 1 < argc && !strcmp(argv[i], "--board")) options.board = argv[++i];
+    else if (i + 1 < argc && !strcmp(argv[i], "--threads")) options.threads = std::max(1, atoi(argv[++i]));
+  }
+
+  TaskPool pool(std::max(1u, options.threads));
+
+  if (check) {
+    int failures = 0;
+
+    for (const Known& known : KNOWN) {
+      Options at = options;
+      at.board = known.board;
+      at.seed = known.seed;
+      at.queue = known.queue;
+      at.hold = known.hold;
+
+      for (size_t depth = 1; depth <= known.counts.size(); depth++) {
+        at.depth = depth;
+        Position root;
+        makeRoot(at, root);
+        uint64_t count = Perft(at, pool).run(root);
+
+        bool ok = count == known.counts[depth - 1];
+        failures += !ok;
+        printf("  %-7s seed %llu queue %-5s %-7s depth %zu: %10llu %s\n", known.board, (unsigned long long)known.seed,
+          known.queue[0] ? known.queue : "-", known.hold ? "hold" : "no hold", depth, (unsigned long long)count,
+          ok ? "ok" : "MISMATCH");
+        if (!ok) printf("    expected %llu\n", (unsigned long long)known.counts[depth - 1]);
+      }
+    }
+
+    printf("%d mismatches\n", failures);
+    return failures == 0 ? 0 : 1;
+  }
+
+  Position root;
+  if (!makeRoot(options, root)) {
+    fprintf(stderr, "unknown board %s, try empty, tall or cheese\n", options.board.c_str());
+    return 1;
+  }
+
+  printf("%s board, seed %llu, queue %s, %s, %u threads\n", options.board.c_str(), (unsigned long long)options.seed,
+    options.queue.empty() ? "from the seed" : options.queue.c_str(), options.hold ? "hold" : "no hold", pool.size());
+
+  // every depth up to the one asked for, as chess engines do, so the growth of the tree shows.
+  for (int depth = 1; depth <= options.depth; depth++) {
+    Options at = options;
+    at.depth = depth;
+    Perft perft(at, pool);
+    std::vector<std::pair<std::string, uint64_t>> divided;
+
+    Clock::time_point start = Clock::now();
+    uint64_t count = perft.run(root, options.divide && depth == options.depth ? &divided : nullptr);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    printf("  depth %d: %14llu sequences, %14llu nodes in %8.3f s, %7.2f M nodes/s\n", depth, (unsigned long long)count,
+      (unsigned long long)perft.nodes(), seconds, perft.nodes() / std::max(seconds, 1e-9) / 1e6);
+
+    for (const auto& [name, subtree] : divided)
+      printf("    %-20s %llu\n", name.c_str(), (unsigned long long)subtree);
+  }
+
+  return 0;
+}
@@ -0,0 +1,68 @@
+// plays a replay file back headlessly as fast as possible and checks it ends where the recording did.
+// usage: replay FILE [--seek TICK]
+
+#include "../engine/replay.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: replay FILE [--seek TICK]\n");
+    return 1;
+  }
+
+  long long seekTo = -1;
+  for (int i = 2; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "--seek")) seekTo = atoll(argv[i + 1]);
+  }
+
+  Replay replay;
+  if (!replay.open(argv[1])) {
+    fprintf(stderr, "%s is not a readable replay for this build\n", argv[1]);
+    return 1;
+  }
+
+  const Replays::Header& header = replay.header();
+  printf("%s: seed %llu, %u ticks/s, %llu ticks, %llu inputs, %llu keyframes, score %lld\n", argv[1],
+    (unsigned long long)header.seed, header.tickRate, (unsigned long long)header.length, (unsigned long long)header.events,
+    (unsigned long long)header.keyframes, (long long)header.score);
+
+  Engine engine;
+  Replay::Cursor cursor;
+
+  // ticks of the keyframes, to compare hashes at while playing through them.
+  std::vector<uint64_t> checks;
+  for (uint64_t i = 0; i < replay.keyframes(); i++) checks.push_back(replay.keyframeTick(i));
+  size_t check = 0;
+  long long strayed = -1;
+
+  Clock::time_point start = Clock::now();
+  replay.seek(engine, cursor, 0);
+  do {
+    for (; check < checks.size() && checks[check] <= engine.getTicks(); check++) {
+      if (checks[check] == engine.getTicks() && strayed < 0 && engine.hash() != replay.keyframeHash(check))
+        strayed = checks[check];
+    }
+  } while (replay.step(engine, cursor));
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  bool matches = engine.getTicks() == header.length && engine.getScore() == header.score && strayed < 0;
+  printf("  played to tick %llu, score %d in %.3f ms (%.0f ticks/s): %s\n", (unsigned long long)engine.getTicks(),
+    engine.getScore(), seconds * 1e3, engine.getTicks() / seconds, matches ? "matches" : "DESYNC");
+  if (strayed >= 0) printf("  first differs from the recording at the keyframe on tick %lld\n", strayed);
+
+  if (seekTo >= 0) {
+    start = Clock::now();
+    replay.seek(engine, cursor, seekTo);
+    seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    printf("  seek to tick %lld: %.3f ms, score %d, %d pieces\n", seekTo, seconds * 1e3, engine.getScore(), engine.getPieces());
+  }
+
+  return matches ? 0 : 2;
+}
@@ -0,0 +1,204 @@
+// runs many headless games in parallel and reports throughput and result distributions.
+// usage: selfplay [--games N] [--threads N] [--seed N] [--policy random|bot] [--randomizer bag|history|classic] [--max-pieces N] [--record DIR]
+
+#include "../engine/bot.hpp"
+#include "../engine/engine.hpp"
+#include "../engine/placements.hpp"
+#include "../engine/replay.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// decides what to do on every tick of a game by filling in the inputs to send before it.
+// one instance per worker, reused across its games.
+class Policy {
+public:
+  virtual ~Policy() = default;
+
+  virtual void begin(uint32_t seed) {}
+  virtual void step(const Engine& engine, std::vector<Input>& inputs) = 0;
+};
+
+// hard drops every block into a uniformly random reachable placement.
+class RandomPolicy : public Policy {
+public:
+  void begin(uint32_t seed) override { random.seed(seed); }
+
+  void step(const Engine& engine, std::vector<Input>& inputs) override {
+    const Block& block = engine.block();
+    placements.generate(engine.getBoard(), block.type, block.x, block.y, block.rotation);
+
+    if (placements.all().empty()) inputs.assign(1, Input::HardDrop);
+    else placements.path(placements.all()[random.below(placements.all().size())], inputs);
+  }
+private:
+  Xoshiro256 random;
+  Placements placements;
+};
+
+// the built-in bot, searching on the worker's own thread since the games already use every core.
+class BotPolicy : public Policy {
+public:
+  BotPolicy(): pool(1), bot(pool) {}
+
+  void step(const Engine& engine, std::vector<Input>& inputs) override {
+    bot.decide(engine, inputs);
+  }
+private:
+  TaskPool pool;
+  Bot bot;
+};
+
+const std::map<std::string, Randomizer> RANDOMIZERS = {
+  { "bag", Randomizer::Bag },
+  { "history", Randomizer::History },
+  { "classic", Randomizer::Classic },
+};
+
+const std::map<std::string, std::function<std::unique_ptr<Policy>()>> POLICIES = {
+  { "random", [] { return std::make_unique<RandomPolicy>(); } },
+  { "bot", [] { return std::make_unique<BotPolicy>(); } },
+};
+
+struct Result {
+  int score, lines, level, pieces;
+  uint64_t ticks;
+};
+
+struct Worker {
+  std::vector<Result> results;
+  Clock::duration busy = Clock::duration::zero();
+};
+
+static void printDistribution(const char* name, std::vector<int> values) {
+  std::sort(values.begin(), values.end());
+
+  double mean = 0;
+  for (int value : values) mean += value;
+  mean /= values.size();
+
+  auto at = [&](double q) { return values[std::min(values.size() - 1, size_t(q * values.size()))]; };
+
+  printf("  %-7s mean %10.1f  min %7d  p10 %7d  p50 %7d  p90 %7d  max %7d\n",
+    name, mean, values.front(), at(0.1), at(0.5), at(0.9), values.back());
+}
+
+int main(int argc, char** argv) {
+  int games = 1000;
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  uint32_t seed = 1;
+  std::string policy = "random";
+  std::string randomizer = "bag";
+  int maxPieces = 100000;
+  const char* record = nullptr;
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "--games")) games = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "--threads")) threads = std::max(1, atoi(argv[i + 1]));
+    else if (!strcmp(argv[i], "--seed")) seed = strtoul(argv[i + 1], nullptr, 10);
+    else if (!strcmp(argv[i], "--policy")) policy = argv[i + 1];
+    else if (!strcmp(argv[i], "--randomizer")) randomizer = argv[i + 1];
+    else if (!strcmp(argv[i], "--max-pieces")) maxPieces = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "--record")) record = argv[i + 1];
+    else {
+      fprintf(stderr, "unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  if (!POLICIES.count(policy) || !RANDOMIZERS.count(randomizer) || games <= 0) {
+    fprintf(stderr, "usage: selfplay [--games N] [--threads N] [--seed N] [--policy random|bot] [--randomizer bag|history|classic] [--max-pieces N] [--record DIR]\n");
+    return 1;
+  }
+
+  std::vector<Worker> workers(threads);
+  std::vector<std::thread> running;
+  std::atomic<int> nextGame(0);
+
+  Clock::time_point start = Clock::now();
+
+  for (unsigned w = 0; w < threads; w++) {
+    running.emplace_back([&, w] {
+      Worker& worker = workers[w];
+      std::unique_ptr<Policy> player = POLICIES.at(policy)();
+      Engine engine(0, RANDOMIZERS.at(randomizer));
+      ReplayRecorder recorder;
+      std::vector<Input> inputs;
+
+      for (int game = nextGame++; game < games; game = nextGame++) {
+        Clock::time_point began = Clock::now();
+
+        // every game's seed depends only on the base seed and its index, whichever worker runs it.
+        uint32_t gameSeed = seed * 0x9e3779b9u + game;
+        engine.seed(gameSeed);
+        engine.reset();
+        player->begin(gameSeed);
+        if (record) recorder.begin(engine, gameSeed, RANDOMIZERS.at(randomizer));
+
+        while (engine.getPieces() < maxPieces) {
+          inputs.clear();
+          player->step(engine, inputs);
+
+          for (Input input : inputs) {
+            if (record) recorder.input(engine, input);
+            engine.input(input);
+          }
+
+          if (!engine.tick()) break;
+          if (record) recorder.tick(engine);
+        }
+
+        if (record) {
+          std::string path = std::string(record) + "/" + std::to_string(game) + ".replay";
+          if (!recorder.save(path.c_str(), engine)) fprintf(stderr, "failed to write %s\n", path.c_str());
+        }
+
+        worker.results.push_back({ engine.getScore(), engine.getLinesCleared(), engine.getLevel(), engine.getPieces(), engine.getTicks() });
+        worker.busy += Clock::now() - began;
+      }
+    });
+  }
+
+  for (std::thread& thread : running) thread.join();
+
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  std::vector<int> scores, lines, levels, pieces;
+  uint64_t totalPieces = 0, totalTicks = 0;
+
+  for (const Worker& worker : workers) {
+    for (const Result& result : worker.results) {
+      scores.push_back(result.score);
+      lines.push_back(result.lines);
+      levels.push_back(result.level);
+      pieces.push_back(result.pieces);
+      totalPieces += result.pieces;
+      totalTicks += result.ticks;
+    }
+  }
+
+  printf("%d games, policy %s, %s randomizer, %u threads, seed %u, %.3f s\n", games, policy.c_str(), randomizer.c_str(), threads, seed, seconds);
+  printf("  %.1f games/s  %.0f pieces/s  %.0f ticks/s\n", games / seconds, totalPieces / seconds, totalTicks / seconds);
+
+  printDistribution("score", scores);
+  printDistribution("lines", lines);
+  printDistribution("level", levels);
+  printDistribution("pieces", pieces);
+
+  for (unsigned w = 0; w < threads; w++) {
+    printf("  worker %2u: %5zu games, %5.1f%% busy\n", w, workers[w].results.size(),
+      100.0 * std::chrono::duration<double>(workers[w].busy).count() / seconds);
+  }
+
+  return 0;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include "constants.hpp"
+#include <algorithm>
+
+// where the board sits in the window, in drawable pixels (which on high-DPI displays outnumber window points).
+// the engine only knows tiles; this is the one place they turn into pixels.
+struct View {
+  // drawable size of the window.
+  int width = Window::WIDTH;
+  int height = Window::HEIGHT;
+
+  int tileSize = TILE_SIZE;
+  // top left corner of the board.
+  int left = 0;
+  int top = 0;
+
+  // the largest whole tile size that fits the board into width x height, centered.
+  static inline View fit(int width, int height) {
+    View view;
+    view.width = width;
+    view.height = height;
+    view.tileSize = std::max(1, std::min(width / COLUMNS, height / ROWS));
+    view.left = (width - view.boardWidth()) / 2;
+    view.top = (height - view.boardHeight()) / 2;
+    return view;
+  }
+
+  inline int boardWidth() const { return COLUMNS * tileSize; }
+  inline int boardHeight() const { return ROWS * tileSize; }
+
+  // pixel position of the top left corner of a tile. row 0 is at the bottom.
+  inline SDL_Point tile(int x, int y) const {
+    return { left + x * tileSize, top + (ROWS - 1 - y) * tileSize };
+  }
+};